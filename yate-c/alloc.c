@@ -0,0 +1,131 @@
+/*** includes ***/
+
+#define _DEFAULT_SOURCE
+#define _BSD_SOURCE
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+
+/*** data ***/
+#define ALLOC_SITES 1024 // a power of 2, far more than the call sites in the editor
+
+struct allocSite {
+    const char *file; // NULL for a free slot
+    int line;
+    long long calls; // malloc, realloc and strdup calls
+    long long frees;
+    long long bytes; // bytes asked for
+    long long copied; // bytes realloc() copied because it moved the block
+};
+
+struct allocSite alloc_sites[ALLOC_SITES];
+pthread_mutex_t alloc_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*** call sites ***/
+struct allocSite *allocSiteFor(const char *file, int line) {
+    /* Open addressing on the address of the __FILE__ string and the line, called with alloc_lock held. */
+    unsigned long h = ((unsigned long) file >> 4) * 31 + line;
+    for(int i = 0; i < ALLOC_SITES; i++) {
+        struct allocSite *site = &alloc_sites[(h + i) & (ALLOC_SITES - 1)];
+        if(site->file == file && site->line == line) return site;
+        if(site->file == NULL) {
+            site->file = file;
+            site->line = line;
+            return site;
+        }
+    }
+    return NULL; // full, the call goes uncounted
+}
+
+void allocCount(const char *file, int line, size_t bytes, size_t copied, int frees) {
+    pthread_mutex_lock(&alloc_lock);
+    struct allocSite *site = allocSiteFor(file, line);
+    if(site) {
+        if(frees) site->frees++;
+        else site->calls++;
+        site->bytes += bytes;
+        site->copied += copied;
+    }
+    pthread_mutex_unlock(&alloc_lock);
+}
+
+/*** allocator ***/
+void *allocMalloc(size_t size, const char *file, int line) {
+    allocCount(file, line, size, 0, 0);
+    return malloc(size);
+}
+
+void *allocRealloc(void *ptr, size_t size, const char *file, int line) {
+    size_t old = yateUsableSize(ptr, size); // without glibc, at most size is copied
+    void *new = realloc(ptr, size);
+    // when the block moved, realloc() copied the old contents over
+    size_t copied = (new && ptr && new != ptr) ? (old < size ? old : size) : 0;
+    allocCount(file, line, size, copied, 0);
+    return new;
+}
+
+void allocFree(void *ptr, const char *file, int line) {
+    if(ptr) allocCount(file, line, 0, 0, 1);
+    free(ptr);
+}
+
+char *allocStrdup(const char *s, const char *file, int line) {
+    allocCount(file, line, strlen(s) + 1, 0, 0);
+    return strdup(s);
+}
+
+/*** report ***/
+int allocEnabled() {
+#ifdef YATE_ALLOC_STATS
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+void allocReset() {
+    pthread_mutex_lock(&alloc_lock);
+    memset(alloc_sites, 0, sizeof(alloc_sites));
+    pthread_mutex_unlock(&alloc_lock);
+}
+
+int allocCompare(const void *a, const void *b) {
+    const struct allocSite *x = a, *y = b;
+    if(x->calls != y->calls) return x->calls < y->calls ? 1 : -1;
+    return (x->bytes < y->bytes) - (x->bytes > y->bytes);
+}
+
+void allocReport(FILE *fp, int top) {
+    /* The top call sites by number of allocations, and the totals. */
+    if(!allocEnabled()) {
+        fprintf(fp, "allocation stats are off, build with make ALLOC_STATS=1\n");
+        return;
+    }
+    pthread_mutex_lock(&alloc_lock);
+    struct allocSite sorted[ALLOC_SITES];
+    int n = 0;
+    struct allocSite total = { "total", 0, 0, 0, 0, 0 };
+    for(int i = 0; i < ALLOC_SITES; i++) {
+        if(alloc_sites[i].file == NULL) continue;
+        sorted[n++] = alloc_sites[i];
+        total.calls += alloc_sites[i].calls;
+        total.frees += alloc_sites[i].frees;
+        total.bytes += alloc_sites[i].bytes;
+        total.copied += alloc_sites[i].copied;
+    }
+    pthread_mutex_unlock(&alloc_lock);
+    qsort(sorted, n, sizeof(struct allocSite), allocCompare);
+
+    fprintf(fp, "%12s %12s %14s %14s  %s\n", "calls", "frees", "bytes", "realloc copy", "call site");
+    for(int i = 0; i < n && i < top; i++) {
+        if(sorted[i].calls == 0) break; // only frees from here on
+        fprintf(fp, "%12lld %12lld %14lld %14lld  %s:%d\n", sorted[i].calls, sorted[i].frees, sorted[i].bytes,
+            sorted[i].copied, sorted[i].file, sorted[i].line);
+    }
+    fprintf(fp, "%12lld %12lld %14lld %14lld  total\n", total.calls, total.frees, total.bytes, total.copied);
+}
@@ -0,0 +1,49 @@
+#ifndef YATE_ALLOC_H
+#define YATE_ALLOC_H
+
+/*** alloc ***/
+/* Every allocation of the editor goes through these macros, so that it can be watched from one place.
+
+In a normal build they are exactly malloc(), realloc(), free() and strdup(). Built with -DYATE_ALLOC_STATS
+(make ALLOC_STATS=1), each call is counted against the file and line it comes from: the number of calls,
+the bytes asked for, and the bytes realloc() had to copy because it moved the block. allocReport() prints
+the call sites that allocate the most, which is how to check that a change really removed allocations
+from a hot path, and to notice when they creep back.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* How much of the heap the block at ptr takes, for the memory budget and the reports. With glibc, it's what
+malloc_usable_size() says, which includes what malloc() rounded up; other C libraries can't tell, and it's size,
+the bytes the block was asked for. 0 when ptr is NULL, and then size isn't evaluated. */
+#ifdef __GLIBC__
+#include <malloc.h>
+#define yateUsableSize(ptr, size) malloc_usable_size(ptr)
+#else
+#define yateUsableSize(ptr, size) ((ptr) ? (size_t) (size) : 0)
+#endif
+
+#ifdef YATE_ALLOC_STATS
+#define yateMalloc(size) allocMalloc((size), __FILE__, __LINE__)
+#define yateRealloc(ptr, size) allocRealloc((ptr), (size), __FILE__, __LINE__)
+#define yateFree(ptr) allocFree((ptr), __FILE__, __LINE__)
+#define yateStrdup(s) allocStrdup((s), __FILE__, __LINE__)
+#else
+#define yateMalloc(size) malloc(size)
+#define yateRealloc(ptr, size) realloc((ptr), (size))
+#define yateFree(ptr) free(ptr)
+#define yateStrdup(s) strdup(s)
+#endif
+
+void *allocMalloc(size_t size, const char *file, int line);
+void *allocRealloc(void *ptr, size_t size, const char *file, int line);
+void allocFree(void *ptr, const char *file, int line);
+char *allocStrdup(const char *s, const char *file, int line);
+
+int allocEnabled();
+void allocReset();
+void allocReport(FILE *fp, int top);
+
+#endif
@@ -0,0 +1,270 @@
+/*** check ***/
+/* Regression checks for the editor, run by make check. Each case drives the editor through editorProcessKey()
+against the virtual terminal of vterm.c, or calls the core directly, and says what it expected when it fails.
+The exit status is the number of failed cases.
+
+Usage: bench/check [-c case]
+*/
+
+/*** includes ***/
+
+#define _DEFAULT_SOURCE
+#define _BSD_SOURCE
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "editor.h"
+#include "lz.h"
+#include "vterm.h"
+
+/*** harness ***/
+struct vterm vt;
+int failed_checks;
+
+#define CHECK(cond, ...) do { \
+    if(!(cond)) { \
+        printf("    %s:%d: ", __FILE__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+        failed_checks++; \
+    } \
+} while(0)
+
+ssize_t vtRead(void *buf, size_t count) {
+    (void) buf;
+    (void) count;
+    return 0; // the cases hand the keys to editorProcessKey() themselves
+}
+
+int vtPending() {
+    return 0; // so editorIdle() runs the idle tasks to the end
+}
+
+ssize_t vtWrite(const void *buf, size_t count) {
+    vtFeed(&vt, buf, count);
+    return count;
+}
+
+void startEditor(int rows, int cols, int lines) {
+    // an editor on an untitled buffer of `lines` numbered rows
+    vtInit(&vt, rows, cols);
+    struct editorIO io = { vtRead, vtWrite, vtPending, NULL, NULL, NULL, NULL };
+    initEditor(io, rows, cols);
+    for(int i = 0; i < lines; i++) {
+        char line[32];
+        int len = snprintf(line, sizeof(line), "line %d", i);
+        editorInsertRow(E.buf, i, line, len);
+    }
+    editorRefreshScreen();
+}
+
+void stopEditor() {
+    editorFree();
+    vtFree(&vt);
+}
+
+void keys(int key, int times) {
+    // press key, and draw the frame after it like the main loop does
+    while(times--) {
+        editorProcessKey(key);
+        editorRefreshScreen();
+    }
+}
+
+/*** cases ***/
+void checkWindowsOwnEdits() {
+    /* The active window sees its own edits in its subscription: they must not move its cursor a second time once
+    another window becomes active. */
+    startEditor(24, 80, 40);
+    keys(CTRL_KEY('w'), 1);
+    keys('s', 1);
+    keys(ARROW_DOWN, 10);
+    keys('\r', 3);
+    CHECK(E.cy == 13, "cursor on row %d after three Enter at row 10, expected 13", E.cy);
+    int edited = E.window;
+    keys(CTRL_KEY('w'), 1);
+    keys('w', 1);
+    CHECK(E.window != edited, "Ctrl-W w stayed in window %d", E.window);
+    CHECK(E.windows[edited].cy == 13, "the window left has its cursor on row %d, expected 13", E.windows[edited].cy);
+    CHECK(E.cy == 0, "the other window has its cursor on row %d, expected 0 (the edits are below it)", E.cy);
+
+    // and back: the edits made in the other window are followed, once
+    keys('\r', 2);
+    keys(CTRL_KEY('w'), 1);
+    keys('w', 1);
+    CHECK(E.window == edited, "Ctrl-W w didn't go back to window %d", edited);
+    CHECK(E.cy == 15, "cursor on row %d after 2 rows were inserted above it, expected 15", E.cy);
+    stopEditor();
+}
+
+void checkBlockEnter() {
+    // Enter ends a block selection, and that's all it does
+    startEditor(24, 80, 10);
+    keys(CTRL_KEY('b'), 1);
+    keys(ARROW_DOWN, 2);
+    keys('\r', 1);
+    CHECK(!E.block, "the block selection is still active after Enter");
+    CHECK(E.buf->numrows == 10, "%d rows after Enter ended the selection, expected 10", E.buf->numrows);
+    stopEditor();
+}
+
+void checkSearchCountKept() {
+    // moving between the matches keeps the count of the query, the file didn't change
+    startEditor(24, 80, 20);
+    keys(CTRL_KEY('f'), 1);
+    for(const char *q = "line 1"; *q; q++) keys(*q, 1);
+    editorIdle();
+    CHECK(E.search_matches == 11, "%d matches of \"line 1\", expected 11", E.search_matches);
+    keys(ARROW_DOWN, 2);
+    CHECK(E.search_matches == 11, "%d matches after moving to the next ones, expected 11 still", E.search_matches);
+    keys('\x1b', 1);
+    CHECK(E.search_matches == -1, "%d matches once the search is over, expected -1", E.search_matches);
+    stopEditor();
+}
+
+void lzRoundTrip(const char *what, const char *src, int len) {
+    /* Compress src and decompress it back, with room for exactly len bytes and then one byte short. */
+    int cap = lzBound(len);
+    char *data = malloc(cap);
+    char *back = malloc(len + 1);
+    int n = lzCompress(src, len, data, cap);
+    CHECK(n > 0, "%s: %d bytes didn't compress within lzBound() = %d", what, len, cap);
+    if(n > 0) {
+        int got = lzDecompress(data, n, back, len);
+        CHECK(got == len, "%s: decompressed %d bytes out of %d", what, got, len);
+        CHECK(got != len || !memcmp(src, back, len), "%s: the %d bytes decompressed differ", what, len);
+        if(len > 0) CHECK(lzDecompress(data, n, back, len - 1) == -1, "%s: decompressed into a buffer too small", what);
+    }
+    free(data);
+    free(back);
+}
+
+void checkLzRoundTrip() {
+    int len = 300000; // past LZ_MAX_OFFSET, and long runs that need many length bytes
+    char *src = malloc(len);
+    srand(42);
+
+    lzRoundTrip("empty", "", 0);
+    lzRoundTrip("one byte", "x", 1);
+
+    for(int i = 0; i < len; i++) src[i] = "abcdefghij \t\n;(){}"[rand() % 18];
+    lzRoundTrip("random text", src, len);
+
+    memset(src, 'a', len);
+    lzRoundTrip("one repeated byte", src, len);
+    for(int i = 0; i < len; i++) src[i] = "int x = 0;\n"[i % 11];
+    lzRoundTrip("repeated line", src, len);
+
+    for(int i = 0; i < len; i++) src[i] = rand() & 0xff;
+    lzRoundTrip("random bytes", src, len);
+    int cap = lzBound(len);
+    char *data = malloc(cap);
+    CHECK(lzCompress(src, len, data, len) == 0, "random bytes got smaller, from %d bytes", len);
+
+    // a corrupt block is refused, not decompressed past the buffers
+    for(int i = 0; i < 1000; i++) {
+        int n = rand() % 64 + 1;
+        for(int k = 0; k < n; k++) data[k] = rand() & 0xff;
+        int got = lzDecompress(data, n, src, 256);
+        CHECK(got >= -1 && got <= 256, "a random block of %d bytes decompressed to %d bytes", n, got);
+    }
+    free(data);
+    free(src);
+}
+
+void checkFrozenRows() {
+    /* Rows frozen and read back give their text back: empty ones, long ones and ones that don't compress. */
+    struct editorBuffer b;
+    editorBufferInit(&b);
+    int big = 70000;
+    char *s = malloc(big);
+    srand(7);
+    for(int i = 0; i < big; i++) s[i] = i % 97 ? "value = next(value); "[i % 21] : 'a' + rand() % 26;
+    char noise[100];
+    for(int i = 0; i < 100; i++) noise[i] = 'a' + rand() % 26;
+    for(int i = 0; i < 200; i++) {
+        switch(i % 5) {
+            case 0: editorInsertRow(&b, i, "", 0); break;
+            case 1: editorInsertRow(&b, i, "\tint same_line = 1;", 19); break;
+            case 2: editorInsertRow(&b, i, s, big); break;
+            case 3: editorInsertRow(&b, i, noise, 100); break;
+            default: editorInsertRow(&b, i, "", 0); break;
+        }
+    }
+    char **before = malloc(sizeof(char *) * b.numrows);
+    for(int i = 0; i < b.numrows; i++) before[i] = strdup(b.row[i].chars);
+    editorBufferFreeze(&b, 0, b.numrows - 1);
+    int frozen = 0;
+    for(int i = 0; i < b.numrows; i++) frozen += b.row[i].chunk != NULL;
+    CHECK(frozen > 0, "no row was frozen");
+    for(int i = 0; i < b.numrows; i++) {
+        const char *text = editorRowText(&b.row[i]);
+        CHECK((int) strlen(text) == b.row[i].size && !strcmp(text, before[i]), "row %d came back different", i);
+        free(before[i]);
+    }
+    free(before);
+    free(s);
+    editorBufferFree(&b);
+}
+
+void checkCorruptChunk() {
+    /* A frozen chunk whose data got corrupted loses the text of its rows, not the buffer. */
+    startEditor(24, 80, 200);
+    editorBufferFreeze(E.buf, 0, E.buf->numrows - 1);
+    struct editorChunk *c = E.buf->row[50].chunk;
+    CHECK(c != NULL, "row 50 wasn't frozen");
+    if(c) {
+        memset(c->data, 0xff, c->len);
+        keys(ARROW_DOWN, 50); // the cursor goes through the rows of the chunk
+        CHECK(E.buf->row[50].chunk == NULL, "row 50 is still in the corrupt chunk");
+        CHECK(!strcmp(editorRowText(&E.buf->row[50]), "???????"), "row 50 reads \"%s\", expected ???????",
+            editorRowText(&E.buf->row[50]));
+        CHECK(strstr(E.statusmsg, "corrupted") != NULL, "the status bar says \"%s\"", E.statusmsg);
+        CHECK(E.buf->damaged == 0, "%d damaged rows left to report", E.buf->damaged);
+        keys('x', 1);
+        CHECK(E.buf->numrows == 200, "%d rows after typing, expected 200", E.buf->numrows);
+    }
+    stopEditor();
+}
+
+struct check {
+    const char *name;
+    void (*run)();
+};
+
+struct check checks[] = {
+    { "windows-own-edits", checkWindowsOwnEdits },
+    { "block-enter", checkBlockEnter },
+    { "search-count-kept", checkSearchCountKept },
+    { "lz-round-trip", checkLzRoundTrip },
+    { "frozen-rows", checkFrozenRows },
+    { "corrupt-chunk", checkCorruptChunk },
+};
+#define CHECKS (sizeof(checks) / sizeof(checks[0]))
+
+int main(int argc, char *argv[]) {
+    const char *only = NULL;
+    int opt, failed = 0;
+
+    while((opt = getopt(argc, argv, "c:")) != -1) {
+        switch(opt) {
+            case 'c': only = optarg; break;
+            default:
+                fprintf(stderr, "Usage: %s [-c case]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    for(unsigned int i = 0; i < CHECKS; i++) {
+        if(only && strcmp(only, checks[i].name)) continue;
+        failed_checks = 0;
+        checks[i].run();
+        printf("%-24s %s\n", checks[i].name, failed_checks ? "FAIL" : "ok");
+        if(failed_checks) failed++;
+    }
+    return failed;
+}
@@ -0,0 +1,212 @@
+/*** includes ***/
+
+#define _DEFAULT_SOURCE
+#define _BSD_SOURCE
+#define _GNU_SOURCE
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "corpus.h"
+
+/*** output ***/
+struct corpusOut {
+    FILE *fp;
+    long long written;
+    long long limit; // stop writing here, one byte before the requested size (the final newline goes there)
+    unsigned int rng; // xorshift32 state
+};
+
+unsigned int corpusRand(struct corpusOut *o, unsigned int n) {
+    // a random number in [0, n), from a tiny generator we control, so the corpus doesn't depend on the libc
+    unsigned int x = o->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    o->rng = x;
+    return n ? x % n : 0;
+}
+
+void corpusPut(struct corpusOut *o, const char *s, size_t len) {
+    if(o->written + (long long) len > o->limit) len = o->limit - o->written;
+    fwrite(s, 1, len, o->fp);
+    o->written += len;
+}
+
+void corpusPrintf(struct corpusOut *o, const char *fmt, ...) {
+    char buf[1024];
+    va_list ap;
+    va_start(ap, fmt);
+    int len = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    if(len > (int) sizeof(buf) - 1) len = sizeof(buf) - 1;
+    corpusPut(o, buf, len);
+}
+
+const char *corpusPick(struct corpusOut *o, const char **words, int n) {
+    return words[corpusRand(o, n)];
+}
+
+/*** generators ***/
+const char *c_types[] = { "int", "long", "char *", "double", "size_t", "unsigned int", "struct node *" };
+const char *c_names[] = { "count", "buffer", "node", "len", "index", "value", "offset", "limit", "key", "row" };
+
+void genC(struct corpusOut *o) {
+    // one function, sometimes preceded by a multi-line comment
+    unsigned int id = corpusRand(o, 100000);
+    if(corpusRand(o, 4) == 0) {
+        corpusPrintf(o, "/* %s_%u: walks the %s and returns the %s,\n", corpusPick(o, c_names, 10), id,
+            corpusPick(o, c_names, 10), corpusPick(o, c_names, 10));
+        corpusPrintf(o, " * or -1 when the %s is out of range. */\n", corpusPick(o, c_names, 10));
+    }
+    corpusPrintf(o, "static %s %s_%u(%s a, const char *s) {\n", corpusPick(o, c_types, 7),
+        corpusPick(o, c_names, 10), id, corpusPick(o, c_types, 7));
+    int lines = 2 + corpusRand(o, 8);
+    for(int i = 0; i < lines; i++) {
+        switch(corpusRand(o, 5)) {
+            case 0: corpusPrintf(o, "\t%s %s = %u;\n", corpusPick(o, c_types, 7), corpusPick(o, c_names, 10), corpusRand(o, 4096)); break;
+            case 1: corpusPrintf(o, "\tif(%s > 0x%x && s != NULL) {\n\t\tprintf(\"%s %%d: %%s\\n\", %s, s); // %s\n\t}\n",
+                corpusPick(o, c_names, 10), corpusRand(o, 256), corpusPick(o, c_names, 10), corpusPick(o, c_names, 10),
+                corpusPick(o, c_names, 10)); break;
+            case 2: corpusPrintf(o, "\tfor(int j = 0; j < %s; j++) %s[j] = '%c';\n", corpusPick(o, c_names, 10),
+                corpusPick(o, c_names, 10), 'a' + corpusRand(o, 26)); break;
+            case 3: corpusPrintf(o, "\t// %s the %s before the %s\n", corpusPick(o, c_names, 10), corpusPick(o, c_names, 10),
+                corpusPick(o, c_names, 10)); break;
+            case 4: corpusPrintf(o, "\twhile(%s--) %s += %u.%u;\n", corpusPick(o, c_names, 10), corpusPick(o, c_names, 10),
+                corpusRand(o, 100), corpusRand(o, 100)); break;
+        }
+    }
+    corpusPrintf(o, "\treturn %s;\n}\n\n", corpusPick(o, c_names, 10));
+}
+
+const char *log_levels[] = { "INFO ", "INFO ", "INFO ", "DEBUG", "WARN ", "ERROR" };
+const char *log_paths[] = { "/api/v1/items", "/api/v1/users", "/healthz", "/api/v2/search", "/static/app.js" };
+
+void genLog(struct corpusOut *o) {
+    unsigned int t = corpusRand(o, 86400);
+    corpusPrintf(o, "2024-05-%02uT%02u:%02u:%02u.%03uZ %s [worker-%u] request_id=%08x method=%s path=%s/%u status=%u duration_ms=%u.%u",
+        1 + corpusRand(o, 28), t / 3600, t / 60 % 60, t % 60, corpusRand(o, 1000), corpusPick(o, log_levels, 6),
+        corpusRand(o, 16), corpusRand(o, 0xffffffff), corpusRand(o, 3) ? "GET" : "POST", corpusPick(o, log_paths, 5),
+        corpusRand(o, 100000), corpusRand(o, 10) ? 200 : 500, corpusRand(o, 2000), corpusRand(o, 10));
+
+    unsigned int r = corpusRand(o, 200);
+    if(r < 4) { // a request payload dumped on the same line, 2 to 20 KB long
+        int fields = 40 + corpusRand(o, 400);
+        corpusPut(o, " payload={", 10);
+        for(int i = 0; i < fields; i++) {
+            corpusPrintf(o, "%s\"%s_%d\":\"%08x%08x\"", i ? "," : "", corpusPick(o, c_names, 10), i,
+                corpusRand(o, 0xffffffff), corpusRand(o, 0xffffffff));
+        }
+        corpusPut(o, "}", 1);
+    }
+    corpusPut(o, "\n", 1);
+    if(r == 199) { // a stack trace, indented with tabs
+        int frames = 5 + corpusRand(o, 30);
+        corpusPrintf(o, "java.lang.IllegalStateException: %s is not ready\n", corpusPick(o, c_names, 10));
+        for(int i = 0; i < frames; i++) {
+            corpusPrintf(o, "\tat com.example.%s.%sHandler.handle(%sHandler.java:%u)\n", corpusPick(o, c_names, 10),
+                corpusPick(o, c_names, 10), corpusPick(o, c_names, 10), corpusRand(o, 900));
+        }
+    }
+}
+
+void genMakefile(struct corpusOut *o) {
+    unsigned int id = corpusRand(o, 100000);
+    corpusPrintf(o, "%s_%u\t\t:= %s.o %s.o\t# %s\n", corpusPick(o, c_names, 10), id, corpusPick(o, c_names, 10),
+        corpusPick(o, c_names, 10), corpusPick(o, c_names, 10));
+    corpusPrintf(o, "target_%u: %s_%u.o \\\n\t\t%s.o \\\n\t\t%s.o\n", id, corpusPick(o, c_names, 10), id,
+        corpusPick(o, c_names, 10), corpusPick(o, c_names, 10));
+    int recipe = 1 + corpusRand(o, 5);
+    for(int i = 0; i < recipe; i++) {
+        switch(corpusRand(o, 3)) {
+            case 0: corpusPrintf(o, "\t$(CC) $(CFLAGS)\t-o $@\t$^\n"); break;
+            case 1: corpusPrintf(o, "\t@echo \"\tbuilt $@ (%u)\"\n", corpusRand(o, 1000)); break;
+            case 2: corpusPrintf(o, "\tif [ -d %s ]; then \\\n\t\trm -rf %s; \\\n\tfi\n", corpusPick(o, c_names, 10),
+                corpusPick(o, c_names, 10)); break;
+        }
+    }
+    corpusPut(o, "\n", 1);
+}
+
+void genJSON(struct corpusOut *o) {
+    // one minified document per line, 2 to 8 MB, always closed properly even when the size limit is near
+    long long target = (2 + corpusRand(o, 7)) * 1024LL * 1024;
+    if(target > o->limit - o->written) target = o->limit - o->written;
+    long long start = o->written;
+
+    corpusPrintf(o, "{\"id\":%u,\"items\":[", corpusRand(o, 1000000));
+    int first = 1;
+    while(o->written - start + 160 < target) {
+        corpusPrintf(o, "%s{\"%s\":\"%s\",\"n\":%u.%u,\"tags\":[\"%s\",\"%s\"],\"nested\":{\"ok\":%s,\"v\":null}}",
+            first ? "" : ",", corpusPick(o, c_names, 10), corpusPick(o, c_names, 10), corpusRand(o, 1000),
+            corpusRand(o, 100), corpusPick(o, c_names, 10), corpusPick(o, c_names, 10),
+            corpusRand(o, 2) ? "true" : "false");
+        first = 0;
+    }
+    corpusPut(o, "]}\n", 3);
+}
+
+const char *utf8_phrases[] = {
+    "Ça va très bien, merci.", "naïve café à côté", "日本語のテキストです。", "中文字符和标点，", "한국어 문장입니다",
+    "Привет, мир!", "Ελληνικά γράμματα", "العربية من اليمين", "emoji 😀🚀🎉", "e\xcc\x81 a\xcc\x8a o\xcc\x88 (combining)",
+    "plain ascii words", "the quick brown fox", "jumps over the lazy dog", "Größe und Maß", "½ ¾ € £ ¥ ©"
+};
+
+void genUTF8(struct corpusOut *o) {
+    int phrases = 3 + corpusRand(o, 10);
+    for(int i = 0; i < phrases; i++) {
+        const char *p = corpusPick(o, utf8_phrases, 15);
+        if(i) corpusPut(o, " ", 1);
+        corpusPut(o, p, strlen(p));
+    }
+    corpusPut(o, "\n", 1);
+}
+
+/*** corpus ***/
+const char *corpus_kinds[] = { "c", "log", "makefile", "json", "utf8", NULL };
+void (*corpus_generators[])(struct corpusOut *o) = { genC, genLog, genMakefile, genJSON, genUTF8 };
+
+int corpusKindIndex(const char *kind) {
+    for(int i = 0; corpus_kinds[i]; i++) {
+        if(!strcmp(kind, corpus_kinds[i])) return i;
+    }
+    return -1;
+}
+
+int corpusIsKind(const char *kind) {
+    return corpusKindIndex(kind) != -1;
+}
+
+long long corpusParseSize(const char *s) {
+    // "4096", "64K", "1M", "4G"; -1 if it doesn't parse
+    char *end;
+    long long n = strtoll(s, &end, 10);
+    if(end == s || n < 0) return -1;
+    switch(*end) {
+        case '\0': return n;
+        case 'k': case 'K': n *= 1024LL; break;
+        case 'm': case 'M': n *= 1024LL * 1024; break;
+        case 'g': case 'G': n *= 1024LL * 1024 * 1024; break;
+        default: return -1;
+    }
+    return end[1] == '\0' ? n : -1;
+}
+
+int corpusWrite(const char *kind, long long size, unsigned int seed, const char *path) {
+    /* Write exactly size bytes of the given kind to path, ending with a newline. Returns 0, or -1 on errors. */
+    int k = corpusKindIndex(kind);
+    if(k == -1 || size < 1) return -1;
+
+    FILE *fp = fopen(path, "w");
+    if(!fp) return -1;
+
+    struct corpusOut o = { fp, 0, size - 1, seed ? seed : 1 };
+    while(o.written < o.limit) corpus_generators[k](&o);
+    fputc('\n', fp);
+
+    int err = ferror(fp);
+    if(fclose(fp) == EOF || err) return -1;
+    return 0;
+}
@@ -0,0 +1,21 @@
+#ifndef YATE_CORPUS_H
+#define YATE_CORPUS_H
+
+/*** corpus ***/
+/* Synthetic, but realistic, test inputs for the benchmarks. The same kind, size and seed always give
+the same bytes, so results can be compared across releases.
+
+    c         C sources: functions, comments (some of them multi-line), strings, numbers, tab indentation
+    log       application logs, with the occasional very long line (stack traces, request payloads)
+    makefile  tab-heavy Makefiles: recipes, aligned variables, line continuations
+    json      minified JSON, one document per line, each line several MB long
+    utf8      mixed UTF-8 prose: accents, CJK, emoji and combining marks next to plain ASCII
+*/
+
+extern const char *corpus_kinds[];
+
+int corpusIsKind(const char *kind);
+long long corpusParseSize(const char *s);
+int corpusWrite(const char *kind, long long size, unsigned int seed, const char *path);
+
+#endif
@@ -0,0 +1,49 @@
+/*** gencorpus ***/
+/* Writes a synthetic test input, see corpus.h for the kinds.
+
+Usage: bench/gencorpus [-t kind] [-s size] [-S seed] file
+    bench/gencorpus -t log -s 64M /tmp/app.log
+*/
+
+/*** includes ***/
+
+#define _DEFAULT_SOURCE
+#define _BSD_SOURCE
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "corpus.h"
+
+void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-t kind] [-s size] [-S seed] file\n", prog);
+    fprintf(stderr, "kinds:");
+    for(int i = 0; corpus_kinds[i]; i++) fprintf(stderr, " %s", corpus_kinds[i]);
+    fprintf(stderr, "; sizes like 4096, 64K, 1M or 4G\n");
+    exit(1);
+}
+
+int main(int argc, char *argv[]) {
+    const char *kind = "c";
+    long long size = 1024 * 1024;
+    unsigned int seed = 1;
+    int opt;
+
+    while((opt = getopt(argc, argv, "t:s:S:")) != -1) {
+        switch(opt) {
+            case 't': kind = optarg; break;
+            case 's': size = corpusParseSize(optarg); break;
+            case 'S': seed = strtoul(optarg, NULL, 10); break;
+            default: usage(argv[0]);
+        }
+    }
+    if(optind != argc - 1 || !corpusIsKind(kind) || size < 1) usage(argv[0]);
+
+    if(corpusWrite(kind, size, seed, argv[optind]) == -1) {
+        perror(argv[optind]);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,328 @@
+/*** micro ***/
+/* Microbenchmarks for the row and syntax hot paths.
+
+Every case runs on synthetic data of a few sizes, calibrating the number of iterations until it has run for at
+least -t seconds, and prints one JSON object per line:
+
+    {"bench":"editorUpdateRow","case":"tabs/len=4096","iters":65536,"ns_per_op":9123.4,"mb_per_s":449.0}
+
+mb_per_s is the number of input bytes the operation goes through per second (the row, the buffer...), or 0 when
+that doesn't make sense. Compare two runs to catch regressions or to weigh a data-structure change.
+
+Usage: bench/micro [-t seconds] [-b filter]
+*/
+
+/*** includes ***/
+
+#define _DEFAULT_SOURCE
+#define _BSD_SOURCE
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "editor.h"
+
+/*** timing ***/
+double min_time = 0.2; // seconds each case runs for, at least
+const char *filter = NULL;
+
+struct timespec timer_start;
+long timer_ns; // time accumulated between benchResume() and benchPause()
+int timer_running;
+
+void benchResume() {
+    clock_gettime(CLOCK_MONOTONIC, &timer_start);
+    timer_running = 1;
+}
+
+void benchPause() {
+    // stop the clock while a case does its untimed setup and cleanup
+    if(!timer_running) return;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    timer_ns += (now.tv_sec - timer_start.tv_sec) * 1000000000L + (now.tv_nsec - timer_start.tv_nsec);
+    timer_running = 0;
+}
+
+void measure(const char *bench, const char *name, long bytes_per_op, void (*fn)(void *ctx, long iters), void *ctx) {
+    /* Run fn with more and more iterations, until it takes at least min_time, and report the last run. */
+    char full[128];
+    snprintf(full, sizeof(full), "%s/%s", bench, name);
+    if(filter && !strstr(full, filter)) return;
+
+    long iters = 1;
+    while(1) {
+        timer_ns = 0;
+        benchResume();
+        fn(ctx, iters);
+        benchPause();
+
+        if(timer_ns >= min_time * 1e9 || iters >= 1000000000L) break;
+        // aim 20% past the target, growing at least 2x and at most 100x at a time
+        long next = timer_ns > 0 ? (long) (iters * (min_time * 1e9 * 1.2) / timer_ns) : iters * 100;
+        if(next < iters * 2) next = iters * 2;
+        if(next > iters * 100) next = iters * 100;
+        iters = next;
+    }
+
+    double ns_per_op = (double) timer_ns / iters;
+    double mb_per_s = bytes_per_op ? bytes_per_op / ns_per_op * 1e9 / (1024 * 1024) : 0;
+    printf("{\"bench\":\"%s\",\"case\":\"%s\",\"iters\":%ld,\"ns_per_op\":%.1f,\"mb_per_s\":%.1f}\n",
+        bench, name, iters, ns_per_op, mb_per_s);
+    fflush(stdout);
+}
+
+/*** synthetic data ***/
+const char *c_line = "\tif(value > 42 && names[i] != NULL) { count += strlen(names[i]); } // count\n";
+const char *comment_line = "/* the quick brown fox jumps over the lazy dog, again and again and again */";
+const char *string_line = "\"the quick brown fox \\\"jumps\\\" over the lazy dog\", 'x', \"again\", ";
+const char *plain_line = "the quick brown fox jumps over the lazy dog and then some more plain words ";
+
+char *makeLine(const char *pattern, int len, int tabs) {
+    // repeat pattern up to len chars, optionally turning its spaces into tabs; no newlines in a row
+    int plen = strlen(pattern);
+    char *s = malloc(len + 1);
+    for(int i = 0; i < len; i++) {
+        char c = pattern[i % plen];
+        if(c == '\n') c = ' ';
+        if(tabs && c == ' ') c = '\t';
+        s[i] = c;
+    }
+    s[len] = '\0';
+    return s;
+}
+
+void makeBuffer(struct editorBuffer *b, const char *filename, int rows, const char *pattern, int len) {
+    editorBufferInit(b);
+    b->filename = strdup(filename);
+    editorSelectSyntaxHighlight(b);
+    char *line = makeLine(pattern, len, 0);
+    for(int i = 0; i < rows; i++) editorInsertRow(b, b->numrows, line, len);
+    free(line);
+}
+
+/*** editorInsertRow ***/
+struct insertRowCase {
+    int rows;
+    int where; // 0 start, 1 middle, 2 end
+};
+
+void benchInsertRow(void *ctx, long iters) {
+    struct insertRowCase *c = ctx;
+    struct editorBuffer b;
+    benchPause();
+    makeBuffer(&b, "bench.c", c->rows, c_line, 80);
+
+    char *line = makeLine(c_line, 80, 0);
+    while(iters > 0) {
+        // insert in batches, and take the rows out again untimed, so the buffer keeps its size
+        long batch = iters < 1000 ? iters : 1000;
+        int at = c->where == 0 ? 0 : c->where == 1 ? b.numrows / 2 : b.numrows;
+        benchResume();
+        for(long i = 0; i < batch; i++) editorInsertRow(&b, at, line, 80);
+        benchPause();
+        for(long i = 0; i < batch; i++) editorDelRow(&b, at);
+        iters -= batch;
+    }
+    free(line);
+    editorBufferFree(&b);
+}
+
+/*** editorRowInsertChar ***/
+struct insertCharCase {
+    int len;
+    int where; // 0 start, 1 middle, 2 end
+};
+
+void benchRowInsertChar(void *ctx, long iters) {
+    struct insertCharCase *c = ctx;
+    struct editorBuffer b;
+    benchPause();
+    makeBuffer(&b, "bench.c", 1, c_line, c->len);
+
+    while(iters > 0) {
+        long batch = iters < 64 ? iters : 64;
+        int at = c->where == 0 ? 0 : c->where == 1 ? c->len / 2 : c->len;
+        benchResume();
+        for(long i = 0; i < batch; i++) editorRowInsertChar(&b, &b.row[0], at, 'x');
+        benchPause();
+        for(long i = 0; i < batch; i++) editorRowDelChar(&b, &b.row[0], at);
+        iters -= batch;
+    }
+    editorBufferFree(&b);
+}
+
+/*** editorUpdateRow ***/
+struct updateRowCase {
+    int len;
+    int tabs;
+};
+
+void benchUpdateRow(void *ctx, long iters) {
+    struct updateRowCase *c = ctx;
+    struct editorBuffer b;
+    benchPause();
+    editorBufferInit(&b); // no filetype: this measures rendering, the syntax has its own benchmark
+    char *line = makeLine(plain_line, c->len, c->tabs);
+    editorInsertRow(&b, 0, line, c->len);
+    free(line);
+
+    benchResume();
+    for(long i = 0; i < iters; i++) editorUpdateRow(&b, &b.row[0]);
+    benchPause();
+    editorBufferFree(&b);
+}
+
+/*** editorUpdateSyntax ***/
+struct syntaxCase {
+    const char *pattern;
+    int len;
+    int rows; // > 1: open and close a comment on the first row, cascading through all the rows
+};
+
+void benchUpdateSyntax(void *ctx, long iters) {
+    struct syntaxCase *c = ctx;
+    struct editorBuffer b;
+    benchPause();
+    makeBuffer(&b, "bench.c", c->rows, c->pattern, c->len);
+
+    if(c->rows == 1) {
+        benchResume();
+        for(long i = 0; i < iters; i++) editorUpdateSyntax(&b, &b.row[0]);
+        benchPause();
+    }
+    else {
+        // one op opens a comment at the start of the first row, and closes it again
+        erow *first = &b.row[0];
+        for(long i = 0; i < iters; i++) {
+            for(int open = 1; open >= 0; open--) {
+                memcpy(first->chars, open ? "/*" : "//", 2);
+                editorUpdateRender(first);
+                benchResume();
+                editorUpdateSyntax(&b, first);
+                benchPause();
+            }
+        }
+    }
+    editorBufferFree(&b);
+}
+
+/*** editorRowsToString ***/
+void benchRowsToString(void *ctx, long iters) {
+    int rows = *(int *) ctx;
+    struct editorBuffer b;
+    benchPause();
+    makeBuffer(&b, "bench.txt", rows, plain_line, 60);
+
+    for(long i = 0; i < iters; i++) {
+        size_t len;
+        benchResume();
+        char *s = editorRowsToString(&b, &len);
+        benchPause();
+        free(s);
+    }
+    editorBufferFree(&b);
+}
+
+/*** editorFindCallback ***/
+struct findCase {
+    int rows;
+    int hit; // 1: every 100th row matches, 0: nothing matches and every key scans the whole file
+};
+
+void benchFindCallback(void *ctx, long iters) {
+    struct findCase *c = ctx;
+    benchPause();
+    struct editorIO io = { NULL, NULL, NULL, NULL, NULL, NULL, NULL }; // the search never draws anything
+    initEditor(io, 24, 80);
+    makeBuffer(E.buf, "bench.c", c->rows, c_line, 80);
+    for(int i = 0; i < c->rows; i += 100) memcpy(E.buf->row[i].chars, "\tneedle", 7);
+    for(int i = 0; i < c->rows; i += 100) editorUpdateRow(E.buf, &E.buf->row[i]);
+
+    char *query = c->hit ? "needle" : "haystack";
+    editorFindCallback(query, 'x'); // a new query starts from the top
+    benchResume();
+    for(long i = 0; i < iters; i++) editorFindCallback(query, ARROW_DOWN);
+    benchPause();
+    editorFindCallback(query, '\r');
+
+    editorFree();
+}
+
+/*** main ***/
+int main(int argc, char *argv[]) {
+    int opt;
+    while((opt = getopt(argc, argv, "t:b:")) != -1) {
+        switch(opt) {
+            case 't': min_time = atof(optarg); break;
+            case 'b': filter = optarg; break;
+            default:
+                fprintf(stderr, "Usage: %s [-t seconds] [-b filter]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    const char *where[] = { "start", "middle", "end" };
+    char name[64];
+
+    int row_counts[] = { 1000, 100000 };
+    for(int r = 0; r < 2; r++) {
+        for(int w = 0; w < 3; w++) {
+            struct insertRowCase c = { row_counts[r], w };
+            snprintf(name, sizeof(name), "%s/rows=%d", where[w], c.rows);
+            measure("editorInsertRow", name, 80, benchInsertRow, &c);
+        }
+    }
+
+    int lens[] = { 16, 4096, 65536 };
+    for(int l = 0; l < 3; l++) {
+        for(int w = 0; w < 3; w++) {
+            struct insertCharCase c = { lens[l], w };
+            snprintf(name, sizeof(name), "%s/len=%d", where[w], c.len);
+            measure("editorRowInsertChar", name, c.len, benchRowInsertChar, &c);
+        }
+    }
+
+    int row_lens[] = { 80, 4096 };
+    for(int l = 0; l < 2; l++) {
+        for(int tabs = 0; tabs < 2; tabs++) {
+            struct updateRowCase c = { row_lens[l], tabs };
+            snprintf(name, sizeof(name), "%s/len=%d", tabs ? "tabs" : "notabs", c.len);
+            measure("editorUpdateRow", name, c.len, benchUpdateRow, &c);
+        }
+    }
+
+    struct { const char *name; const char *pattern; } kinds[] = {
+        { "code", c_line }, { "comment", comment_line }, { "string", string_line }
+    };
+    for(int k = 0; k < 3; k++) {
+        for(int l = 0; l < 2; l++) {
+            struct syntaxCase c = { kinds[k].pattern, row_lens[l], 1 };
+            snprintf(name, sizeof(name), "%s/len=%d", kinds[k].name, c.len);
+            measure("editorUpdateSyntax", name, c.len, benchUpdateSyntax, &c);
+        }
+    }
+    for(int r = 0; r < 2; r++) {
+        struct syntaxCase c = { c_line, 80, row_counts[r] };
+        snprintf(name, sizeof(name), "cascade/rows=%d", c.rows);
+        measure("editorUpdateSyntax", name, 2 * 80L * c.rows, benchUpdateSyntax, &c);
+    }
+
+    for(int r = 0; r < 2; r++) {
+        snprintf(name, sizeof(name), "rows=%d", row_counts[r]);
+        measure("editorRowsToString", name, 61L * row_counts[r], benchRowsToString, &row_counts[r]);
+    }
+
+    for(int r = 0; r < 2; r++) {
+        for(int hit = 1; hit >= 0; hit--) {
+            struct findCase c = { row_counts[r], hit };
+            snprintf(name, sizeof(name), "%s/rows=%d", hit ? "hit" : "miss", c.rows);
+            measure("editorFindCallback", name, hit ? 0 : 80L * c.rows, benchFindCallback, &c);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,441 @@
+/*** replay ***/
+/* Deterministic keystroke replay benchmark.
+
+Feeds key sequences into editorProcessKeypress() against the in-memory virtual terminal of vterm.c, so it runs
+without a TTY (on a headless Linux box, in CI...), and reports for each session:
+    - the per-key latency percentiles: from the moment the editor starts reading a key until the frame that
+      shows its effect has been handed to write(),
+    - the bytes emitted per frame,
+    - the allocations made while replaying (malloc/calloc/realloc calls, wrapped at link time with --wrap).
+
+The built-in sessions (typing, pasting, searching, scrolling, block editing and two windows) run against a synthetic C
+document, so the numbers only change when the editor does. A real session can be recorded with
+YATE_RECORD=keys.bin ./yate file and replayed with -k keys.bin -f file; keep in mind that all the input is
+available at once when replaying, so a lone ESC followed by another key is read as an escape sequence.
+-a N prints the N call sites that allocated the most in each session, when built with make ALLOC_STATS=1
+(see alloc.h). -T trace.json also records a Chrome trace-event timeline of the replay (see trace.h); the allocation counts
+then include the trace buffers. -e draws runs of the same character with REP, ECH and CUF, like on a terminal
+that supports them (see editorAppendRun()); the screens are the same, only B/frame should go down.
+-p N starts N workers (0 for one per core), so that big terminals (-r 120 -c 400) draw their rows in parallel
+(see editorComposeRows()); the screens are the same, only the latency should go down.
+-m bytes sets the memory budget of the buffers and checks it after every key, so the rows away from the screen are
+evicted, frozen and rebuilt all the time (see editorMemoryCheck()); the screens are the same, only the allocations
+go up.
+
+Usage: bench/replay [-r rows] [-c cols] [-l lines] [-f file] [-k keys] [-s session] [-d] [-e] [-p threads] [-m bytes] [-a top] [-T trace]
+*/
+
+/*** includes ***/
+
+#define _DEFAULT_SOURCE
+#define _BSD_SOURCE
+#define _GNU_SOURCE
+
+#include <setjmp.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "alloc.h"
+#include "editor.h"
+#include "pool.h"
+#include "trace.h"
+#include "vterm.h"
+
+/*** allocation counting ***/
+/* The benchmark is linked with -Wl,--wrap=malloc (and calloc, realloc, free), so every call the editor makes
+goes through these. Allocations made inside libc itself, like the ones of strdup() or getline(), are not seen.
+With -p the workers allocate too, so the counters are atomic. */
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+long alloc_calls = 0;
+long alloc_bytes = 0;
+
+void *__wrap_malloc(size_t size) {
+    __atomic_add_fetch(&alloc_calls, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&alloc_bytes, size, __ATOMIC_RELAXED);
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size) {
+    __atomic_add_fetch(&alloc_calls, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&alloc_bytes, nmemb * size, __ATOMIC_RELAXED);
+    return __real_calloc(nmemb, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    __atomic_add_fetch(&alloc_calls, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&alloc_bytes, size, __ATOMIC_RELAXED);
+    return __real_realloc(ptr, size);
+}
+
+void __wrap_free(void *ptr) {
+    __real_free(ptr);
+}
+
+/*** key buffer ***/
+struct keybuf {
+    char *b;
+    size_t len;
+    size_t burst; // where the keys start coming all at once, see kbBurst()
+};
+#define KEYBUF_INIT {NULL, 0, SIZE_MAX}
+
+void kbAppend(struct keybuf *kb, const char *s, size_t len) {
+    kb->b = realloc(kb->b, kb->len + len);
+    memcpy(&kb->b[kb->len], s, len);
+    kb->len += len;
+}
+
+void kbString(struct keybuf *kb, const char *s) {
+    kbAppend(kb, s, strlen(s));
+}
+
+void kbBurst(struct keybuf *kb) {
+    /* The keys appended from now on arrive in one burst, like a paste or a slow link catching up: the editor only
+    draws the frame after the last of them, as editorFrame() does while more input is waiting. */
+    kb->burst = kb->len;
+}
+
+void kbKey(struct keybuf *kb, int key, int times) {
+    // append the bytes a terminal sends for key
+    const char *seq;
+    char c = key;
+    switch(key) {
+        case ARROW_UP: seq = "\x1b[A"; break;
+        case ARROW_DOWN: seq = "\x1b[B"; break;
+        case ARROW_RIGHT: seq = "\x1b[C"; break;
+        case ARROW_LEFT: seq = "\x1b[D"; break;
+        case HOME_KEY: seq = "\x1b[H"; break;
+        case END_KEY: seq = "\x1b[F"; break;
+        case DEL_KEY: seq = "\x1b[3~"; break;
+        case PAGE_UP: seq = "\x1b[5~"; break;
+        case PAGE_DOWN: seq = "\x1b[6~"; break;
+        default:
+            while(times--) kbAppend(kb, &c, 1);
+            return;
+    }
+    while(times--) kbString(kb, seq);
+}
+
+/*** sessions ***/
+void sessionTyping(struct keybuf *kb) {
+    kbKey(kb, PAGE_DOWN, 4);
+    for(int i = 0; i < 40; i++) {
+        char line[80];
+        snprintf(line, sizeof(line), "\tint typed_%d = %d; // typed by hand\r", i, i * 7);
+        kbString(kb, line);
+    }
+    kbKey(kb, BACKSPACE, 30);
+}
+
+void sessionPasting(struct keybuf *kb) {
+    // terminals send pasted newlines as \r, and the whole paste arrives in one burst
+    kbKey(kb, PAGE_DOWN, 2);
+    for(int i = 0; i < 200; i++) {
+        char line[120];
+        snprintf(line, sizeof(line), "static const char *pasted_%d = \"%s\"; /* %d */\r", i,
+            "the quick brown fox jumps over the lazy dog", i);
+        kbString(kb, line);
+    }
+}
+
+void sessionSearching(struct keybuf *kb) {
+    const char *queries[] = { "value_1", "printf", "names_", "no_such_thing" };
+    for(unsigned int q = 0; q < sizeof(queries) / sizeof(queries[0]); q++) {
+        kbKey(kb, CTRL_KEY('f'), 1);
+        kbString(kb, queries[q]);
+        kbKey(kb, ARROW_DOWN, 20);
+        kbKey(kb, ARROW_UP, 5);
+        kbKey(kb, '\r', 1);
+    }
+}
+
+void sessionScrolling(struct keybuf *kb) {
+    kbKey(kb, PAGE_DOWN, 30);
+    kbKey(kb, ARROW_DOWN, 200);
+    kbKey(kb, ARROW_RIGHT, 40);
+    kbKey(kb, END_KEY, 1);
+    kbKey(kb, PAGE_UP, 30);
+    kbKey(kb, ARROW_UP, 100);
+    kbKey(kb, HOME_KEY, 1);
+}
+
+void sessionBlock(struct keybuf *kb) {
+    kbKey(kb, CTRL_KEY('b'), 1);
+    kbKey(kb, ARROW_DOWN, 100);
+    kbString(kb, "// ");
+    kbKey(kb, BACKSPACE, 3);
+    kbKey(kb, ARROW_RIGHT, 8);
+    kbKey(kb, CTRL_KEY('y'), 1);
+    kbKey(kb, CTRL_KEY('x'), 1);
+    kbKey(kb, CTRL_KEY('b'), 1);
+    kbKey(kb, PAGE_DOWN, 3);
+    kbKey(kb, CTRL_KEY('v'), 1);
+}
+
+void sessionWindows(struct keybuf *kb) {
+    /* Two windows on the same buffer: the lower one is left further down, and the upper one deletes rows above
+    it, then adds more. It all comes in one burst, so the lower window catches up with all of it in one frame (see
+    editorWindowFollow()); with -m, the rows it ends up showing were evicted on the way. */
+    kbKey(kb, CTRL_KEY('w'), 1);
+    kbKey(kb, 's', 1);
+    kbKey(kb, PAGE_DOWN, 20);
+    kbKey(kb, CTRL_KEY('w'), 1);
+    kbKey(kb, 'w', 1);
+    kbKey(kb, ARROW_DOWN, 100);
+    kbBurst(kb);
+    kbKey(kb, BACKSPACE, 1500);
+    for(int i = 0; i < 100; i++) kbString(kb, "\tint joined = 1; // typed over the rows deleted\r");
+}
+
+struct session {
+    const char *name;
+    void (*keys)(struct keybuf *kb);
+};
+
+struct session sessions[] = {
+    { "typing", sessionTyping },
+    { "pasting", sessionPasting },
+    { "searching", sessionSearching },
+    { "scrolling", sessionScrolling },
+    { "block", sessionBlock },
+    { "windows", sessionWindows },
+};
+#define SESSIONS (sizeof(sessions) / sizeof(sessions[0]))
+
+/*** virtual terminal I/O ***/
+struct vterm vt;
+jmp_buf replay_done;
+
+const char *input; // keys being replayed
+size_t input_len, input_pos;
+
+struct timespec frame_start;
+int frame_open = 0; // the editor started reading a key, and its frame was not written yet
+
+long *latencies; // per-key latency, in nanoseconds
+long *frame_bytes;
+int nframes, frames_cap;
+
+long elapsedNs(struct timespec *from, struct timespec *to) {
+    return (to->tv_sec - from->tv_sec) * 1000000000L + (to->tv_nsec - from->tv_nsec);
+}
+
+ssize_t vtRead(void *buf, size_t count) {
+    if(count == 0) return 0;
+    if(input_pos == input_len) longjmp(replay_done, 1); // nothing left to replay
+    if(!frame_open) {
+        clock_gettime(CLOCK_MONOTONIC, &frame_start);
+        frame_open = 1;
+    }
+    *(char *) buf = input[input_pos++];
+    return 1;
+}
+
+ssize_t vtWrite(const void *buf, size_t count) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if(frame_open) {
+        if(nframes == frames_cap) {
+            frames_cap = frames_cap ? frames_cap * 2 : 1024;
+            // the harness' own bookkeeping stays out of the allocation counts
+            latencies = __real_realloc(latencies, sizeof(long) * frames_cap);
+            frame_bytes = __real_realloc(frame_bytes, sizeof(long) * frames_cap);
+        }
+        latencies[nframes] = elapsedNs(&frame_start, &now);
+        frame_bytes[nframes] = count;
+        nframes++;
+        frame_open = 0;
+    }
+    vtFeed(&vt, buf, count);
+    return count;
+}
+
+/*** report ***/
+int compareLong(const void *a, const void *b) {
+    long x = *(const long *) a, y = *(const long *) b;
+    return (x > y) - (x < y);
+}
+
+long percentile(long *sorted, int n, double p) {
+    if(n == 0) return 0;
+    int i = (int) (p * (n - 1) + 0.5);
+    return sorted[i];
+}
+
+void report(const char *name, long allocs, long bytes, int dump) {
+    long *lat = malloc(sizeof(long) * (nframes ? nframes : 1));
+    long *out = malloc(sizeof(long) * (nframes ? nframes : 1));
+    long total_out = 0;
+    memcpy(lat, latencies, sizeof(long) * nframes);
+    memcpy(out, frame_bytes, sizeof(long) * nframes);
+    for(int i = 0; i < nframes; i++) total_out += out[i];
+    qsort(lat, nframes, sizeof(long), compareLong);
+    qsort(out, nframes, sizeof(long), compareLong);
+
+    int keys = nframes ? nframes : 1;
+    printf("%-12s %6d %9.1f %9.1f %9.1f %9.1f %9ld %9ld %9ld %10.1f %11.1f  %08lx\n", name, nframes,
+        percentile(lat, nframes, 0.50) / 1000.0, percentile(lat, nframes, 0.90) / 1000.0,
+        percentile(lat, nframes, 0.99) / 1000.0, percentile(lat, nframes, 1.0) / 1000.0,
+        total_out / keys, percentile(out, nframes, 0.99), percentile(out, nframes, 1.0),
+        (double) allocs / keys, (double) bytes / keys / 1024.0, vtChecksum(&vt));
+    if(dump) vtDump(&vt, stdout);
+
+    free(lat);
+    free(out);
+}
+
+/*** replay ***/
+int alloc_top = 0; // how many call sites to print after each session, see -a
+int encode = 0; // flag, -e
+size_t budget = 0; // -m, 0 to leave the default one, checked only once a second
+
+void replay(const char *name, const char *keys, size_t len, size_t burst, const char *file, int rows, int cols, int dump) {
+    vtInit(&vt, rows, cols);
+    struct editorIO io = { vtRead, vtWrite, NULL, NULL, NULL, NULL, NULL };
+    initEditor(io, rows, cols);
+    E.term_rep = E.term_ech = encode;
+    if(budget) E.buffer_budget = budget;
+    if(file && editorOpen(E.buf, (char *) file) == -1) die("fopen");
+
+    // the first paint isn't caused by any key, and neither is loading the file
+    editorRefreshScreen();
+    input = keys;
+    input_len = len;
+    input_pos = 0;
+    nframes = 0;
+    frame_open = 0;
+    alloc_calls = 0;
+    alloc_bytes = 0;
+    allocReset();
+
+    if(setjmp(replay_done) == 0) {
+        while(1) {
+            editorProcessKeypress();
+            if(budget) editorMemoryCheck(1);
+            if(input_pos <= burst) editorRefreshScreen();
+        }
+    }
+    if(frame_open) editorRefreshScreen(); // the end of the last burst
+    long allocs = alloc_calls, bytes = alloc_bytes;
+    report(name, allocs, bytes, dump);
+    if(alloc_top > 0) allocReport(stdout, alloc_top);
+
+    editorFree();
+    vtFree(&vt);
+}
+
+char document_dir[] = "/tmp/yate-replay-XXXXXX";
+
+char *writeDocument(int lines) {
+    /* A synthetic C file with a bit of everything the highlighter cares about. It is the same on every run, and so
+    is the name the status bar shows: it's written in a fresh directory, which becomes the current one, so the
+    editor opens it by a name that has nothing random in it. */
+    static char *path = "document.c";
+    if(!mkdtemp(document_dir)) die("mkdtemp");
+    if(chdir(document_dir) == -1) die(document_dir);
+    FILE *fp = fopen(path, "w");
+    if(!fp) die(path);
+
+    for(int i = 0; i < lines; i++) {
+        switch(i % 8) {
+            case 0: fprintf(fp, "/* block comment number %d,\n", i); break;
+            case 1: fprintf(fp, "   spanning two lines */ int value_%d = %d;\n", i, i * 31); break;
+            case 2: fprintf(fp, "\tif(value_%d > %d.5) {\n", i - 1, i); break;
+            case 3: fprintf(fp, "\t\tprintf(\"row %d: %%s\\n\", names_%d[%d]);\n", i, i % 17, i % 3); break;
+            case 4: fprintf(fp, "\t}\n"); break;
+            case 5: fprintf(fp, "// a line comment with a few words in it, %d\n", i); break;
+            case 6: fprintf(fp, "static char *names_%d[] = { \"alpha\", \"beta\", \"gamma\" };\n", i % 17); break;
+            case 7: fprintf(fp, "\n"); break;
+        }
+    }
+    fclose(fp);
+    return path;
+}
+
+char *readFile(const char *path, size_t *len) {
+    FILE *fp = fopen(path, "rb");
+    if(!fp) die(path);
+    fseek(fp, 0, SEEK_END);
+    *len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char *buf = malloc(*len ? *len : 1);
+    if(fread(buf, 1, *len, fp) != *len) die("fread");
+    fclose(fp);
+    return buf;
+}
+
+int main(int argc, char *argv[]) {
+    int rows = 24, cols = 80, lines = 5000, dump = 0, threads = -1;
+    const char *file = NULL, *keysfile = NULL, *only = NULL, *trace = NULL;
+    int opt;
+
+    while((opt = getopt(argc, argv, "r:c:l:f:k:s:dep:m:a:T:")) != -1) {
+        switch(opt) {
+            case 'r': rows = atoi(optarg); break;
+            case 'c': cols = atoi(optarg); break;
+            case 'l': lines = atoi(optarg); break;
+            case 'f': file = optarg; break;
+            case 'k': keysfile = optarg; break;
+            case 's': only = optarg; break;
+            case 'd': dump = 1; break;
+            case 'e': encode = 1; break;
+            case 'p': threads = atoi(optarg); break;
+            case 'm': budget = strtoull(optarg, NULL, 10); break;
+            case 'a': alloc_top = atoi(optarg); break;
+            case 'T': trace = optarg; break;
+            default:
+                fprintf(stderr, "Usage: %s [-r rows] [-c cols] [-l lines] [-f file] [-k keys] [-s session] [-d] [-e] [-p threads] [-m bytes] [-a top] [-T trace]\n", argv[0]);
+                return 1;
+        }
+    }
+    if(rows < 3 || cols < 1) {
+        fprintf(stderr, "the terminal needs at least 3 rows and 1 column\n");
+        return 1;
+    }
+
+    if(trace && traceStart(trace) == -1) {
+        perror(trace);
+        return 1;
+    }
+
+    if(threads >= 0) poolStart(threads);
+
+    // read before writeDocument() changes the current directory, the names given may be relative to it
+    size_t keys_len = 0;
+    char *keys = keysfile ? readFile(keysfile, &keys_len) : NULL;
+    char *document = NULL;
+    if(!file) file = document = writeDocument(lines);
+
+    printf("# yate replay: %dx%d terminal, %s\n", rows, cols, document ? "synthetic document" : file);
+    printf("%-12s %6s %9s %9s %9s %9s %9s %9s %9s %10s %11s  %s\n", "session", "keys", "p50 us", "p90 us",
+        "p99 us", "max us", "B/frame", "p99 B", "max B", "allocs/key", "KB/key", "screen");
+
+    if(keys) {
+        replay(keysfile, keys, keys_len, keys_len, file, rows, cols, dump);
+        free(keys);
+    }
+    else {
+        for(unsigned int i = 0; i < SESSIONS; i++) {
+            if(only && strcmp(only, sessions[i].name)) continue;
+            struct keybuf kb = KEYBUF_INIT;
+            sessions[i].keys(&kb);
+            replay(sessions[i].name, kb.b, kb.len, kb.burst, file, rows, cols, dump);
+            free(kb.b);
+        }
+    }
+
+    if(document) {
+        unlink(document);
+        rmdir(document_dir);
+    }
+    traceStop();
+    return 0;
+}
@@ -0,0 +1,237 @@
+/*** scale ***/
+/* File-size scaling benchmark.
+
+For every kind of corpus (see corpus.h) and every size, generates the file and measures in a fresh process:
+    open_ms         editorOpen()
+    first_paint_ms  from the start of editorOpen() until the first frame has been written to the virtual terminal
+    search_ms       a search that matches nothing, so it scans the whole buffer
+    save_ms         editorWriteFile() to a new file
+    peak_rss_mb     the process' peak resident set size
+    heap_mb         the heap in use once the first frame is drawn, or once the budget is kept with -m
+One JSON object per line. Between consecutive sizes of the same kind, *_exp is the scaling exponent of each time
+(log(t2 / t1) / log(size2 / size1)): about 1 is linear, and "superlinear" lists the steps that went above 1.2,
+which is what to watch for in editorOpen and editorSave from release to release.
+
+-m bytes sets the memory budget of the buffer (see editorMemoryCheck()), and keeps it after the first frame, before
+the search and the save, which then go through rows that were frozen (see editorBufferFreeze()). freeze_ms is how
+long that took, and heap_mb how much of the file was left.
+
+Usage: bench/scale [-t kinds] [-s sizes] [-d dir] [-S seed] [-m bytes]
+    bench/scale -t log,json -s 1M,16M,256M,1G,4G -d /var/tmp
+    bench/scale -t log -s 64M -m 1
+The buffer takes a few times the size of the file in memory, so the biggest sizes need a big machine.
+*/
+
+/*** includes ***/
+
+#define _DEFAULT_SOURCE
+#define _BSD_SOURCE
+#define _GNU_SOURCE
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "corpus.h"
+#include "editor.h"
+#include "vterm.h"
+
+/*** measurement ***/
+struct result {
+    long long bytes;
+    int rows;
+    double open_ms, first_paint_ms, freeze_ms, search_ms, save_ms;
+    double peak_rss_mb, heap_mb;
+};
+
+struct vterm vt;
+size_t budget = 0; // -m, 0 to leave the buffer alone
+
+ssize_t vtRead(void *buf, size_t count) {
+    (void) buf;
+    (void) count;
+    return 0;
+}
+
+ssize_t vtWrite(const void *buf, size_t count) {
+    vtFeed(&vt, buf, count);
+    return count;
+}
+
+double msSince(struct timespec *from) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - from->tv_sec) * 1e3 + (now.tv_nsec - from->tv_nsec) / 1e6;
+}
+
+void measure(const char *path, const char *save_path, struct result *r) {
+    /* Runs in a child process, so the peak RSS belongs to this file only. */
+    struct timespec start, t;
+    vtInit(&vt, 24, 80);
+    struct editorIO io = { vtRead, vtWrite, NULL, NULL, NULL, NULL, NULL };
+    initEditor(io, 24, 80);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if(editorOpen(E.buf, (char *) path) == -1) die("editorOpen");
+    r->open_ms = msSince(&start);
+    editorRefreshScreen();
+    r->first_paint_ms = msSince(&start);
+    r->rows = E.buf->numrows;
+
+    if(budget) {
+        E.buffer_budget = budget;
+        clock_gettime(CLOCK_MONOTONIC, &t);
+        do editorMemoryCheck(1); while(E.memory_behind); // a check only freezes for so long
+        r->freeze_ms = msSince(&t);
+    }
+    r->heap_mb = editorMemoryHeap() / (1024.0 * 1024);
+
+    int rx;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    if(editorFindRow(E.buf, "\x01no such text\x01", -1, 1, &rx) != -1) die("search");
+    r->search_ms = msSince(&t);
+
+    free(E.buf->filename);
+    E.buf->filename = strdup(save_path);
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    if(editorWriteFile(E.buf) == -1) die("editorWriteFile");
+    r->save_ms = msSince(&t);
+    unlink(save_path);
+
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    r->peak_rss_mb = ru.ru_maxrss / 1024.0; // ru_maxrss is in KB on Linux
+}
+
+int measureInChild(const char *path, const char *save_path, struct result *r) {
+    int fds[2];
+    if(pipe(fds) == -1) return -1;
+
+    pid_t pid = fork();
+    if(pid == -1) return -1;
+    if(pid == 0) {
+        close(fds[0]);
+        measure(path, save_path, r);
+        if(write(fds[1], r, sizeof(*r)) != sizeof(*r)) _exit(1);
+        _exit(0);
+    }
+
+    close(fds[1]);
+    ssize_t nread = read(fds[0], r, sizeof(*r));
+    close(fds[0]);
+    int status;
+    waitpid(pid, &status, 0);
+    if(nread != sizeof(*r)) return WIFSIGNALED(status) ? WTERMSIG(status) : -1;
+    return 0;
+}
+
+/*** report ***/
+double exponent(double t1, double t2, long long s1, long long s2) {
+    if(t1 <= 0 || t2 <= 0) return 0;
+    return log(t2 / t1) / log((double) s2 / s1);
+}
+
+void report(const char *kind, struct result *r, struct result *prev) {
+    printf("{\"kind\":\"%s\",\"bytes\":%lld,\"rows\":%d,\"open_ms\":%.2f,\"first_paint_ms\":%.2f,"
+        "\"search_ms\":%.2f,\"save_ms\":%.2f,\"peak_rss_mb\":%.1f,\"rss_per_byte\":%.2f,\"heap_mb\":%.1f",
+        kind, r->bytes, r->rows, r->open_ms, r->first_paint_ms, r->search_ms, r->save_ms, r->peak_rss_mb,
+        r->peak_rss_mb * 1024 * 1024 / r->bytes, r->heap_mb);
+    if(budget) printf(",\"freeze_ms\":%.2f", r->freeze_ms);
+
+    if(prev) {
+        const char *names[] = { "open", "first_paint", "search", "save" };
+        double now[] = { r->open_ms, r->first_paint_ms, r->search_ms, r->save_ms };
+        double before[] = { prev->open_ms, prev->first_paint_ms, prev->search_ms, prev->save_ms };
+        double exps[4];
+        for(int i = 0; i < 4; i++) {
+            exps[i] = exponent(before[i], now[i], prev->bytes, r->bytes);
+            printf(",\"%s_exp\":%.2f", names[i], exps[i]);
+        }
+        printf(",\"superlinear\":[");
+        int first = 1;
+        for(int i = 0; i < 4; i++) {
+            if(exps[i] <= 1.2) continue;
+            printf("%s\"%s\"", first ? "" : ",", names[i]);
+            first = 0;
+        }
+        printf("]");
+    }
+    printf("}\n");
+    fflush(stdout);
+}
+
+/*** main ***/
+int main(int argc, char *argv[]) {
+    char *kinds = strdup("c,log,makefile,json,utf8");
+    char *sizes = strdup("1M,4M,16M,64M");
+    const char *dir = "/tmp";
+    unsigned int seed = 1;
+    int opt;
+
+    while((opt = getopt(argc, argv, "t:s:d:S:m:")) != -1) {
+        switch(opt) {
+            case 't': free(kinds); kinds = strdup(optarg); break;
+            case 's': free(sizes); sizes = strdup(optarg); break;
+            case 'd': dir = optarg; break;
+            case 'S': seed = strtoul(optarg, NULL, 10); break;
+            case 'm': budget = corpusParseSize(optarg); break;
+            default:
+                fprintf(stderr, "Usage: %s [-t kinds] [-s sizes] [-d dir] [-S seed] [-m bytes]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    char *kind_save, *size_save;
+    for(char *kind = strtok_r(kinds, ",", &kind_save); kind; kind = strtok_r(NULL, ",", &kind_save)) {
+        if(!corpusIsKind(kind)) {
+            fprintf(stderr, "unknown corpus kind: %s\n", kind);
+            return 1;
+        }
+
+        struct result prev;
+        int have_prev = 0;
+        char *list = strdup(sizes);
+        for(char *s = strtok_r(list, ",", &size_save); s; s = strtok_r(NULL, ",", &size_save)) {
+            long long size = corpusParseSize(s);
+            if(size < 1) {
+                fprintf(stderr, "bad size: %s\n", s);
+                return 1;
+            }
+
+            char path[4096], save_path[4096];
+            snprintf(path, sizeof(path), "%s/yate-scale-%s-%s.txt", dir, kind, s);
+            snprintf(save_path, sizeof(save_path), "%s/yate-scale-%s-%s.saved", dir, kind, s);
+            if(corpusWrite(kind, size, seed, path) == -1) {
+                perror(path);
+                return 1;
+            }
+
+            struct result r;
+            memset(&r, 0, sizeof(r));
+            r.bytes = size;
+            int err = measureInChild(path, save_path, &r);
+            unlink(path);
+            if(err) {
+                printf("{\"kind\":\"%s\",\"bytes\":%lld,\"error\":\"measurement failed (%s %d)\"}\n", kind, size,
+                    err > 0 ? "signal" : "status", err);
+                unlink(save_path);
+                break; // bigger sizes won't do better
+            }
+
+            report(kind, &r, have_prev ? &prev : NULL);
+            prev = r;
+            have_prev = 1;
+        }
+        free(list);
+    }
+
+    free(kinds);
+    free(sizes);
+    return 0;
+}
@@ -0,0 +1,201 @@
+/*** includes ***/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vterm.h"
+
+enum vtState {
+    VT_GROUND = 0,
+    VT_ESCAPE,
+    VT_CSI
+};
+
+/*** virtual terminal ***/
+void vtInit(struct vterm *vt, int rows, int cols) {
+    vt->rows = rows;
+    vt->cols = cols;
+    vt->cells = malloc(rows * cols);
+    vt->attrs = malloc(rows * cols);
+    memset(vt->cells, ' ', rows * cols);
+    memset(vt->attrs, 0, rows * cols);
+    vt->cy = 0;
+    vt->cx = 0;
+    vt->wrap_pending = 0;
+    vt->cursor_visible = 1;
+    vt->attr = 0;
+    vt->last = ' ';
+    vt->state = VT_GROUND;
+    vt->seqlen = 0;
+}
+
+void vtFree(struct vterm *vt) {
+    free(vt->cells);
+    free(vt->attrs);
+}
+
+void vtErase(struct vterm *vt, int y, int from, int to) {
+    // erase the cells [from, to) of row y with the current attributes, like a real terminal does
+    if(y < 0 || y >= vt->rows) return;
+    if(from < 0) from = 0;
+    if(to > vt->cols) to = vt->cols;
+    for(int x = from; x < to; x++) {
+        vt->cells[y * vt->cols + x] = ' ';
+        vt->attrs[y * vt->cols + x] = vt->attr & VT_REVERSE;
+    }
+}
+
+void vtLineFeed(struct vterm *vt) {
+    if(vt->cy < vt->rows - 1) {
+        vt->cy++;
+        return;
+    }
+    // scroll the whole screen up one line
+    memmove(vt->cells, &vt->cells[vt->cols], (vt->rows - 1) * vt->cols);
+    memmove(vt->attrs, &vt->attrs[vt->cols], (vt->rows - 1) * vt->cols);
+    vtErase(vt, vt->rows - 1, 0, vt->cols);
+}
+
+void vtPut(struct vterm *vt, char c) {
+    if(vt->wrap_pending) {
+        vt->cx = 0;
+        vtLineFeed(vt);
+        vt->wrap_pending = 0;
+    }
+    vt->cells[vt->cy * vt->cols + vt->cx] = c;
+    vt->attrs[vt->cy * vt->cols + vt->cx] = vt->attr;
+    vt->last = c;
+    if(vt->cx == vt->cols - 1) vt->wrap_pending = 1;
+    else vt->cx++;
+}
+
+void vtSGR(struct vterm *vt, int *params, int nparams) {
+    if(nparams == 0) {
+        vt->attr = 0;
+        return;
+    }
+    for(int i = 0; i < nparams; i++) {
+        int p = params[i];
+        if(p == 0) vt->attr = 0;
+        else if(p == 7) vt->attr |= VT_REVERSE;
+        else if(p == 27) vt->attr &= ~VT_REVERSE;
+        else if(p >= 30 && p <= 37) vt->attr = (vt->attr & VT_REVERSE) | (p - 29);
+        else if(p == 39) vt->attr &= VT_REVERSE;
+    }
+}
+
+void vtCSI(struct vterm *vt, char final) {
+    int params[8];
+    int nparams = 0;
+    int private = (vt->seqlen > 0 && vt->seq[0] == '?');
+
+    // parse the numeric parameters, separated by ';'
+    char *p = &vt->seq[private];
+    char *end = &vt->seq[vt->seqlen];
+    while(p < end && nparams < 8) {
+        int n = 0;
+        while(p < end && *p >= '0' && *p <= '9') n = n * 10 + (*p++ - '0');
+        params[nparams++] = n;
+        if(p < end && *p == ';') p++;
+        else break;
+    }
+    int n = (nparams > 0 && params[0] > 0) ? params[0] : 1;
+
+    vt->wrap_pending = 0;
+    switch(final) {
+        case 'H': {
+            int row = n;
+            int col = (nparams > 1 && params[1] > 0) ? params[1] : 1;
+            vt->cy = (row > vt->rows ? vt->rows : row) - 1;
+            vt->cx = (col > vt->cols ? vt->cols : col) - 1;
+            break;
+        }
+        case 'A': vt->cy = (vt->cy - n < 0) ? 0 : vt->cy - n; break;
+        case 'B': vt->cy = (vt->cy + n >= vt->rows) ? vt->rows - 1 : vt->cy + n; break;
+        case 'C': vt->cx = (vt->cx + n >= vt->cols) ? vt->cols - 1 : vt->cx + n; break;
+        case 'D': vt->cx = (vt->cx - n < 0) ? 0 : vt->cx - n; break;
+        case 'K': {
+            int mode = nparams ? params[0] : 0;
+            if(mode == 0) vtErase(vt, vt->cy, vt->cx, vt->cols);
+            else if(mode == 1) vtErase(vt, vt->cy, 0, vt->cx + 1);
+            else vtErase(vt, vt->cy, 0, vt->cols);
+            break;
+        }
+        case 'J': {
+            int mode = nparams ? params[0] : 0;
+            int y;
+            if(mode == 0) {
+                vtErase(vt, vt->cy, vt->cx, vt->cols);
+                for(y = vt->cy + 1; y < vt->rows; y++) vtErase(vt, y, 0, vt->cols);
+            }
+            else if(mode == 1) {
+                for(y = 0; y < vt->cy; y++) vtErase(vt, y, 0, vt->cols);
+                vtErase(vt, vt->cy, 0, vt->cx + 1);
+            }
+            else {
+                for(y = 0; y < vt->rows; y++) vtErase(vt, y, 0, vt->cols);
+            }
+            break;
+        }
+        case 'X': vtErase(vt, vt->cy, vt->cx, vt->cx + n); break;
+        case 'b': while(n--) vtPut(vt, vt->last); break;
+        case 'm': vtSGR(vt, params, nparams); break;
+        case 'h':
+        case 'l':
+            if(private && nparams && params[0] == 25) vt->cursor_visible = (final == 'h');
+            break;
+    }
+}
+
+void vtFeed(struct vterm *vt, const char *s, size_t len) {
+    for(size_t i = 0; i < len; i++) {
+        char c = s[i];
+        switch(vt->state) {
+            case VT_GROUND:
+                if(c == '\x1b') vt->state = VT_ESCAPE;
+                else if(c == '\r') {
+                    vt->cx = 0;
+                    vt->wrap_pending = 0;
+                }
+                else if(c == '\n') {
+                    vtLineFeed(vt);
+                    vt->wrap_pending = 0;
+                }
+                else if((unsigned char) c >= ' ' && c != 127) vtPut(vt, c);
+                break;
+            case VT_ESCAPE:
+                if(c == '[') {
+                    vt->state = VT_CSI;
+                    vt->seqlen = 0;
+                }
+                else vt->state = VT_GROUND;
+                break;
+            case VT_CSI:
+                if(c >= 0x40 && c <= 0x7e) { // final byte of the sequence
+                    vtCSI(vt, c);
+                    vt->state = VT_GROUND;
+                }
+                else if(vt->seqlen < (int) sizeof(vt->seq)) {
+                    vt->seq[vt->seqlen++] = c;
+                }
+                break;
+        }
+    }
+}
+
+unsigned long vtChecksum(struct vterm *vt) {
+    // FNV-1a over the cells and their attributes, to tell quickly if two runs ended on the same screen
+    unsigned long h = 2166136261UL;
+    for(int i = 0; i < vt->rows * vt->cols; i++) {
+        h = (h ^ (unsigned char) vt->cells[i]) * 16777619UL;
+        h = (h ^ vt->attrs[i]) * 16777619UL;
+    }
+    return h & 0xffffffffUL;
+}
+
+void vtDump(struct vterm *vt, FILE *fp) {
+    for(int y = 0; y < vt->rows; y++) {
+        fprintf(fp, "|%.*s|\n", vt->cols, &vt->cells[y * vt->cols]);
+    }
+}
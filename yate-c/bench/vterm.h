@@ -0,0 +1,34 @@
+#ifndef YATE_VTERM_H
+#define YATE_VTERM_H
+
+/*** virtual terminal ***/
+/* A small in-memory terminal for the benchmarks: it interprets the bytes the editor writes (text, \r, \n and
+the CSI sequences yate emits: H, J, K, m, ?25h/l, C, X and b) into a grid of cells, so a session can run
+without a TTY and its final screen can be compared between runs. */
+
+#include <stdio.h>
+#include <stddef.h>
+
+struct vterm {
+    int rows, cols;
+    char *cells; // rows * cols characters
+    unsigned char *attrs; // SGR state of each cell: foreground color in the low bits, VT_REVERSE on top
+    int cy, cx; // cursor position, 0-indexed
+    int wrap_pending; // the last column was written, the next printable char wraps to the next line
+    int cursor_visible;
+    unsigned char attr; // current SGR state
+    char last; // last printed character, repeated by REP (CSI n b)
+    int state; // parser state: ground, after ESC or inside a CSI sequence
+    char seq[32]; // parameters of the CSI sequence being parsed
+    int seqlen;
+};
+
+#define VT_REVERSE 0x80
+
+void vtInit(struct vterm *vt, int rows, int cols);
+void vtFree(struct vterm *vt);
+void vtFeed(struct vterm *vt, const char *s, size_t len);
+unsigned long vtChecksum(struct vterm *vt);
+void vtDump(struct vterm *vt, FILE *fp);
+
+#endif
@@ -0,0 +1,1006 @@
+/*** includes ***/
+
+// If your compiler complains about getline(), you may need to define a feature test macro
+#define _DEFAULT_SOURCE
+#define _BSD_SOURCE
+#define _GNU_SOURCE
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "alloc.h"
+#include "core.h"
+#include "lz.h"
+#include "perf.h"
+#include "trace.h"
+
+/*** filetypes ***/
+char *C_HL_extensions[] = { ".c", ".h", ".cpp", NULL };
+char *C_HLkeywords[] = {
+    // type 1
+    "switch", "if", "while", "for", "break", "continue", "return", "else",
+    "struct", "union", "typedef", "static", "enum", "class", "case",
+    // type 2
+    "int|", "long|", "double|", "float|", "char|", "unsigned|", "signed|",
+    "void|", "size_t|", NULL
+};
+
+struct editorSyntax HLDB[] = { // highlight database
+    {
+        "c", // filetype
+        C_HL_extensions, // filematch
+        C_HLkeywords, // keywords
+        "//", // yes. you know exactly what's going on!
+        "/*",
+        "*/",
+        HL_HIGHLIGHT_NUMBERS | HL_HIGHLIGHT_STRINGS // flags
+    },
+};
+// define an HLDB_ENTRIES constant to store the length of the HLDB array.
+#define HLDB_ENTRIES (sizeof(HLDB) / sizeof(HLDB[0]))
+
+/*** changes ***/
+/* The dirty flag only says that something changed. Caches of what is derived from the rows (the screen, search
+results, a journal...) need to know what, so they can redo just that part. Every change is recorded here:
+
+- each row keeps the generation of the buffer at the time its text last changed, so anything that remembers
+  a row together with its gen can tell whether it's still the same text;
+- each subscriber gets the range of rows changed since it last called editorConsumeChanges(), plus how many
+  rows were inserted or deleted, which is how far the rows below the range moved. Highlighting changes are
+  in the range too, with the text flag left clear when that's all there was.
+
+Ranges are merged, so a subscriber that looks after every key gets small ranges, and one that looks now and then
+gets a bigger one that covers everything in between. A new subscriber starts with nothing changed, so it builds
+its cache from the whole buffer once and keeps it up to date from there.
+*/
+int editorSubscribe(struct editorBuffer *b) {
+    /* Start recording changes for a new subscriber. Returns its id, or -1 when there are already too many. */
+    for(int id = 0; id < EDITOR_SUBSCRIBERS; id++) {
+        if(b->subscribed[id]) continue;
+        b->subscribed[id] = 1;
+        b->subscribers++;
+        struct editorChanges none = { INT_MAX, -1, 0, 0 };
+        b->changes[id] = none;
+        return id;
+    }
+    return -1;
+}
+
+void editorUnsubscribe(struct editorBuffer *b, int id) {
+    if(id < 0 || id >= EDITOR_SUBSCRIBERS || !b->subscribed[id]) return;
+    b->subscribed[id] = 0;
+    b->subscribers--;
+}
+
+int editorConsumeChanges(struct editorBuffer *b, int id, struct editorChanges *c) {
+    /* Copy what changed since the last call into c, and start over. Returns 1 if anything changed. */
+    if(id < 0 || id >= EDITOR_SUBSCRIBERS || !b->subscribed[id]) return 0;
+    *c = b->changes[id];
+    struct editorChanges none = { INT_MAX, -1, 0, 0 };
+    b->changes[id] = none;
+    return c->first <= c->last || c->shift != 0;
+}
+
+void editorNoteChange(struct editorBuffer *b, int first, int last, int text) {
+    if(!b->subscribers) return;
+    for(int id = 0; id < EDITOR_SUBSCRIBERS; id++) {
+        if(!b->subscribed[id]) continue;
+        struct editorChanges *c = &b->changes[id];
+        if(first < c->first) c->first = first;
+        if(last > c->last) c->last = last;
+        c->text |= text;
+    }
+}
+
+void editorNoteInsert(struct editorBuffer *b, int at) {
+    /* Row `at` is new, and the ones that were from `at` on are one row further down. The range has to reach `at`,
+    or the rows between its end and `at` would seem to have moved when they didn't. */
+    if(!b->subscribers) return;
+    for(int id = 0; id < EDITOR_SUBSCRIBERS; id++) {
+        if(!b->subscribed[id]) continue;
+        struct editorChanges *c = &b->changes[id];
+        if(at < c->first) c->first = at;
+        c->last = (c->last + 1 > at) ? c->last + 1 : at;
+        c->shift++;
+        c->text = 1;
+    }
+}
+
+void editorNoteDelete(struct editorBuffer *b, int at) {
+    /* Row `at` is gone (b->numrows is already one less), the ones below it moved up into its place. */
+    if(!b->subscribers) return;
+    for(int id = 0; id < EDITOR_SUBSCRIBERS; id++) {
+        if(!b->subscribed[id]) continue;
+        struct editorChanges *c = &b->changes[id];
+        if(at < c->first) c->first = at;
+        c->last = (c->last - 1 > at) ? c->last - 1 : at;
+        if(c->last >= b->numrows) c->last = b->numrows - 1;
+        c->shift--;
+        c->text = 1;
+    }
+}
+
+void editorRowsChanged(struct editorBuffer *b, int first, int last) {
+    /* The text of rows [first, last] changed in place. Row operations call this themselves; code that edits
+    the chars of a row directly (see editorRowReplaceRx()) has to call it after. */
+    b->dirty++;
+    b->generation++;
+    for(int y = first; y <= last; y++) b->row[y].gen = b->generation;
+    editorNoteChange(b, first, last, 1);
+}
+
+/*** interruption ***/
+/* Searching a huge file, or a comment opened at the top of it, can take seconds, and the editor doesn't read
+keys meanwhile. So these loops call editorInterrupted() every few thousand rows, which asks the front end
+(the interrupt.check of the buffer they work on) whether Esc or Ctrl-C has arrived, at most every EDITOR_INTERRUPT_NS. When it has,
+the loop stops, leaves the buffer in a consistent state, and says how far it got so the user can be told. */
+#define EDITOR_INTERRUPT_NS 20000000LL // 20 ms
+
+int editorInterrupted(struct editorBuffer *b, const char *what, const char *unit, long long done, long long total) {
+    struct editorInterrupt *in = &b->interrupt;
+    if(in->check == NULL) return 0;
+    long long now = perfNow();
+    if(now < in->next_check) return 0;
+    in->next_check = now + EDITOR_INTERRUPT_NS;
+    if(!in->check()) return 0;
+
+    in->interrupted = 1;
+    in->what = what;
+    in->unit = unit;
+    in->done = done;
+    in->total = total;
+    return 1;
+}
+
+/*** syntax highlighting ***/
+int is_separator(int c) {
+    /* Takes a character and returns true if it’s considered a separator character.
+
+    strchr() comes from <string.h>. It looks for the first occurrence of a character in a string, 
+    and returns a pointer to the matching character in the string. If the string doesn’t contain the character, 
+    strchr() returns NULL.
+    */
+    return isspace(c) || c == '\0' || strchr(",.()+-/*=~%<>[];", c) != NULL;
+}
+
+int editorHighlightRow(struct editorBuffer *b, erow *row) {
+    /*** go through the characters of an erow and highlight them by setting each value in the highlight array.
+     * Returns 1 when the row's hl_open_comment flag changed, so the caller knows the next row needs an update. ***/
+    b->highlighted++;
+    editorNoteChange(b, row->idx, row->idx, 0);
+    if(!row->render) editorUpdateRender(row); // a cold row, reached by a cascade
+    // at least one byte: an empty row still has a highlight, and realloc() of 0 bytes may give back NULL
+    row->highlight = yateRealloc(row->highlight, row->rsize ? row->rsize : 1);
+    // et all characters to HL_NORMAL by default, before looping through the characters and setting the digits to HL_NUMBER. 
+    memset(row->highlight, HL_NORMAL, row->rsize);
+
+    if (b->syntax == NULL) return 0;
+
+    char **keywords = b->syntax->keywords;
+
+    // single-line comments (aliases)
+    char *sc_start = b->syntax->singleline_comment_start;
+    int scs_len = sc_start ? strlen(sc_start) : 0;
+    // multi-line comments (aliases)
+    char *mc_start = b->syntax->multiline_comment_start;
+    char *mc_end = b->syntax->multiline_comment_end;
+    int mcs_len = mc_start ? strlen(mc_start) : 0;
+    int mce_len = mc_end ? strlen(mc_end) : 0;
+
+    int prev_separator = 1; // we consider the beginning of the line to be a separator
+    int in_string = 0;
+    /*initialize in_comment to true if the previous row has an unclosed multi-line comment. 
+    If that’s the case, then the current row will start out being highlighted as a multi-line comment.*/
+    int in_comment = (row->idx > 0 && b->row[row->idx - 1].hl_open_comment);
+
+    int i = 0;
+    while(i < row->rsize) {
+        char c = row->render[i];
+        unsigned char prev_hl = (i > 0) ? row->highlight[i - 1] : HL_NORMAL;
+
+        if(scs_len && !in_string && !in_comment) {
+            if(!strncmp(&row->render[i], sc_start, scs_len)) {
+                memset(&row->highlight[i], HL_COMMENT, row->rsize - i);
+                break; // we asume the rest of the line is all part of the comment, yes!
+            }
+        }
+
+        if(mcs_len && mce_len && !in_string) {
+            if(in_comment) {
+                row->highlight[i] = HL_MLCOMMENT;
+                if (!strncmp(&row->render[i], mc_end, mce_len)) {
+                    memset(&row->highlight[i], HL_MLCOMMENT, mce_len);
+                    i += mce_len;
+                    in_comment = 0;
+                    prev_separator = 1;
+                    continue;
+                }
+
+                i++;
+                continue;
+            }
+            else if(!strncmp(&row->render[i], mc_start, mcs_len)) {
+                memset(&row->highlight[i], HL_MLCOMMENT, mcs_len);
+                i += mcs_len;
+                in_comment = 1;
+                continue;
+            }
+        }
+
+        // we highlight both double-quoted strings and single-quoted strings
+        if(b->syntax->flags & HL_HIGHLIGHT_STRINGS) {
+            if(in_string) {
+                row->highlight[i] = HL_STRING;
+
+                // take escaped quotes into account
+                if (c == '\\' && i + 1 < row->rsize) {
+                    row->highlight[i + 1] = HL_STRING;
+                    i += 2;
+                    continue;
+                }
+
+                if(c == in_string) in_string = 0; // here ends the string
+                i++;
+                prev_separator = 1; // the closing quote is considered a separator.
+                continue;
+            }
+            else {
+                if(c == '"' || c == '\'') {
+                    // We store either a double-quote (") or a single-quote (') character as the value of in_string, 
+                    // so that we know which one closes the string.
+                    in_string = c;
+                    row->highlight[i] = HL_STRING;
+                    i++;
+                    continue;
+                }
+            }
+        }
+
+        if(b->syntax->flags & HL_HIGHLIGHT_NUMBERS) {
+            if((isdigit(c) && (prev_separator || prev_hl == HL_NUMBER)) 
+                || (c == '.' && prev_hl == HL_NUMBER)
+            ) {
+                row->highlight[i] = HL_NUMBER;
+                i++;
+                prev_separator = 0;
+                continue;
+            }
+        }
+
+        if(prev_separator) {
+            int j;
+            for (j = 0; keywords[j]; j++) {
+                int klen = strlen(keywords[j]);
+                int kw2 = keywords[j][klen - 1] == '|'; // detect keywords type 2
+                if(kw2) klen--; // discard pipe from keyword lenght
+
+                if(!strncmp(&row->render[i], keywords[j], klen) && is_separator(row->render[i + klen])) {
+                    memset(&row->highlight[i], kw2 ? HL_KEYWORD2 : HL_KEYWORD1, klen);
+                    i += klen;
+                    break;
+                }
+            }
+            if(keywords[j] != NULL) { // check if a keyword was highligthed (break out from the prev for loop)
+                prev_separator = 0;
+                continue;
+            }
+        }
+
+        prev_separator = is_separator(c);
+        i++;
+    }  
+    int changed = (row->hl_open_comment != in_comment);
+    row->hl_open_comment = in_comment;
+    return changed;
+}
+
+void editorUpdateSyntax(struct editorBuffer *b, erow *row) {
+    /*So far, we have only been updating the syntax of a line when the user changes that specific line. 
+    But with multi-line comments, a user could comment out an entire file just by changing one line. 
+    So it seems like we need to update the syntax of all the lines following the current line. 
+    However, we know the highlighting of the next line will not change if the value of this line’s 
+    hl_open_comment did not change. So we check if it changed, and only move on to the next line
+    if hl_open_comment changed (and if there is a next line in the file).
+    It is a loop rather than a recursion, so opening a comment at the top of a huge file can't overflow the stack.
+
+    Rows past the highlight watermark (b->hl_done) are left alone: editorHighlightStep() gets to them in order,
+    and the cascade stops at the watermark for the same reason. Cold rows (see editorRowEvict()) stay cold, or
+    commenting out the top of a file would bring back the render of all of it.
+    */
+    if(row->idx >= b->hl_done) return;
+    traceBegin("editorUpdateSyntax");
+    int rows = 1;
+    while(1) {
+        int cold = row->render == NULL;
+        int changed = editorHighlightRow(b, row);
+        if(cold) editorRowEvict(row);
+        if(!changed || row->idx + 1 >= b->hl_done) break;
+        row = &b->row[row->idx + 1];
+        rows++;
+        if((rows & 4095) == 0 && editorInterrupted(b, "Highlighting", "rows", rows, b->hl_done - row->idx + rows)) {
+            // the rest of the cascade goes back behind the watermark, editorHighlightStep() will redo it
+            b->hl_done = row->idx;
+            break;
+        }
+    }
+    traceEndArg("cascade", rows);
+}
+
+void editorUpdateSyntaxRange(struct editorBuffer *b, int top, int bottom) {
+    /* Highlight every row in [top, bottom] exactly once, then let the last one cascade as usual.
+    Used by the batched block operations, which rebuild many consecutive rows at the same time. */
+    if(top < 0) top = 0;
+    if(bottom >= b->hl_done) bottom = b->hl_done - 1;
+    if(top > bottom) return;
+
+    for(int y = top; y < bottom; y++) {
+        if(((y - top) & 4095) == 4095 && editorInterrupted(b, "Highlighting", "rows", y - top, bottom - top + 1)) {
+            b->hl_done = y; // like the cascade in editorUpdateSyntax()
+            return;
+        }
+        editorHighlightRow(b, &b->row[y]);
+    }
+    editorUpdateSyntax(b, &b->row[bottom]);
+}
+
+void editorHighlightUpTo(struct editorBuffer *b, int at) {
+    /* Move the watermark past row `at` right now, for the rows that are about to be drawn or searched.
+    A cold row (see editorRowEvict()) is only highlighted for its hl_open_comment, which the rows below need,
+    and goes back to cold: what is drawn is warmed by editorRowWarm(). */
+    while(b->hl_done <= at && b->hl_done < b->numrows) {
+        erow *row = &b->row[b->hl_done];
+        int cold = row->render == NULL;
+        editorHighlightRow(b, row);
+        if(cold) editorRowEvict(row);
+        b->hl_done++;
+    }
+}
+
+int editorHighlightStep(struct editorBuffer *b, long long deadline) {
+    /* Highlight rows past the watermark, in order, until the deadline (perfNow() time, see perf.h).
+    Every row only depends on the one above it, which is already done, so each one is highlighted once.
+    Returns 1 while there are rows left. */
+    while(b->hl_done < b->numrows) {
+        int stop = b->hl_done + 64; // don't read the clock for every row
+        if(stop > b->numrows) stop = b->numrows;
+        editorHighlightUpTo(b, stop - 1);
+        if(perfNow() >= deadline) break;
+    }
+    return b->hl_done < b->numrows;
+}
+
+void editorSelectSyntaxHighlight(struct editorBuffer *b) {
+    b->syntax = NULL;
+    if(b->filename == NULL) return;
+
+    char *extension = strrchr(b->filename, '.');
+
+    for (unsigned int j = 0; j < HLDB_ENTRIES; j++) {
+        struct editorSyntax *s = &HLDB[j];
+        unsigned int i = 0;
+        while (s->filematch[i]) {
+            int is_ext = (s->filematch[i][0] == '.');
+            // strrchr() returns a pointer to the last occurrence of a character in a string,
+            // strcmp() returns 0 if two given strings are equal.
+            if ((is_ext && extension && !strcmp(extension, s->filematch[i])) ||
+                (!is_ext && strstr(b->filename, s->filematch[i]))) {
+                b->syntax = s;
+                editorUpdateSyntaxRange(b, 0, b->numrows - 1);
+                return;
+            }
+            i++;
+        }
+    }
+}
+
+/*** cold storage ***/
+/* The text of the rows far from the screen can be frozen: editorBufferFreeze() compresses the chars of runs of
+consecutive rows together, in chunks of up to EDITOR_CHUNK_BYTES (see lz.h), and frees them. A frozen row keeps
+its size, render and highlight; only its chars are gone, replaced by its chunk and where its text starts in it.
+
+Reading a frozen row (editorRowText()) decompresses its whole chunk, which stays decompressed while it is one of
+the EDITOR_HOT_CHUNKS chunks its buffer read the most recently. A search or a save walks the rows in order, so it
+decompresses each chunk once, and never holds more than a few of them. Changing a frozen row (editorRowThaw())
+gives it back chars of its own, for good: it's up to editorBufferFreeze() to freeze it again later. A chunk that
+doesn't decompress any more costs the text of its rows, but not the buffer (see editorChunkDamaged()).
+*/
+void editorChunkCool(struct editorChunk *c) {
+    // free the decompressed copy of c, the compressed one stays
+    if(!c->hot) return;
+    c->buf->frozen -= yateUsableSize(c->hot, c->raw);
+    yateFree(c->hot);
+    c->hot = NULL;
+}
+
+void editorChunkUnlink(struct editorChunk *c) {
+    // take c out of the hot chunks of its buffer, the ones after it move up
+    struct editorChunk **hot = c->buf->hot;
+    for(int i = 0; i < EDITOR_HOT_CHUNKS; i++) {
+        if(hot[i] != c) continue;
+        memmove(&hot[i], &hot[i + 1], sizeof(*hot) * (EDITOR_HOT_CHUNKS - i - 1));
+        hot[EDITOR_HOT_CHUNKS - 1] = NULL;
+        return;
+    }
+}
+
+void editorChunkRelease(struct editorChunk *c) {
+    /* One of the rows of c was thawed or freed. The chunk goes with the last one. */
+    if(!c || --c->rows > 0) return;
+    editorChunkUnlink(c);
+    editorChunkCool(c);
+    c->buf->frozen -= yateUsableSize(c->data, c->len) + yateUsableSize(c, sizeof(*c));
+    yateFree(c->data);
+    yateFree(c);
+}
+
+void editorChunkDamaged(struct editorChunk *c) {
+    /* The data of c doesn't decompress any more: the memory it was in got corrupted. Rather than take the unsaved
+    edits of the other rows down with it, each of its rows gets chars of its own again, as many '?' as it had, and
+    is rendered from them; b->damaged tells the front end how many rows were lost. */
+    struct editorBuffer *b = c->buf;
+    int left = c->rows; // c goes with the last one
+    for(int j = 0; j < b->numrows && left > 0; j++) {
+        erow *row = &b->row[j];
+        if(row->chunk != c) continue;
+        row->chars = yateMalloc(row->size + 1);
+        memset(row->chars, '?', row->size);
+        row->chars[row->size] = '\0';
+        row->chunk = NULL;
+        row->chunk_off = 0;
+        left--;
+        editorChunkRelease(c);
+        editorRowEvict(row); // highlighted again from the new text before it's drawn, see editorRowWarm()
+        editorUpdateRender(row);
+        editorRowsChanged(b, j, j);
+        b->damaged++;
+    }
+}
+
+const char *editorRowText(erow *row) {
+    /* The chars of the row, null terminated, whether it is frozen or not. The text of a frozen row is only good
+    until EDITOR_HOT_CHUNKS other chunks of the buffer are read, or the row changes: use it right away. */
+    struct editorChunk *c = row->chunk;
+    if(!c) return row->chars;
+
+    struct editorChunk **hot = c->buf->hot;
+    if(hot[0] != c) {
+        if(c->hot) editorChunkUnlink(c);
+        else {
+            // the least recently read chunk makes room for this one
+            if(hot[EDITOR_HOT_CHUNKS - 1]) editorChunkCool(hot[EDITOR_HOT_CHUNKS - 1]);
+            c->hot = yateMalloc(c->raw);
+            if(lzDecompress(c->data, c->len, c->hot, c->raw) != c->raw) {
+                yateFree(c->hot);
+                c->hot = NULL;
+                editorChunkDamaged(c); // row is one of its rows, it has chars of its own now
+                return row->chars;
+            }
+            c->buf->frozen += yateUsableSize(c->hot, c->raw);
+        }
+        memmove(&hot[1], &hot[0], sizeof(*hot) * (EDITOR_HOT_CHUNKS - 1));
+        hot[0] = c;
+    }
+    return c->hot + row->chunk_off;
+}
+
+void editorRowThaw(erow *row) {
+    /* Give a frozen row its own chars again, before they are changed. Does nothing to the other rows. */
+    if(!row->chunk) return;
+    const char *text = editorRowText(row);
+    row->chars = yateMalloc(row->size + 1);
+    memcpy(row->chars, text, row->size + 1);
+    editorChunkRelease(row->chunk);
+    row->chunk = NULL;
+    row->chunk_off = 0;
+}
+
+size_t editorChunkFreeze(struct editorBuffer *b, int first, int end, int raw) {
+    /* Freeze rows [first, end), none of them frozen yet, whose text takes raw bytes with the null bytes. Leaves
+    them alone if they don't get any smaller. Returns how many bytes that gave back. */
+    char *text = yateMalloc(raw);
+    char *data = yateMalloc(raw);
+    int off = 0;
+    for(int j = first; j < end; j++) {
+        memcpy(&text[off], b->row[j].chars, b->row[j].size + 1);
+        off += b->row[j].size + 1;
+    }
+    int len = lzCompress(text, raw, data, raw);
+    yateFree(text);
+    if(len == 0) {
+        yateFree(data);
+        return 0;
+    }
+
+    struct editorChunk *c = yateMalloc(sizeof(struct editorChunk));
+    c->buf = b;
+    c->data = yateRealloc(data, len);
+    c->len = len;
+    c->raw = raw;
+    c->rows = end - first;
+    c->hot = NULL;
+
+    size_t freed = 0;
+    off = 0;
+    for(int j = first; j < end; j++) {
+        erow *row = &b->row[j];
+        freed += yateUsableSize(row->chars, row->size + 1);
+        yateFree(row->chars);
+        row->chars = NULL;
+        row->chunk = c;
+        row->chunk_off = off;
+        off += row->size + 1;
+    }
+    size_t cost = yateUsableSize(c->data, c->len) + yateUsableSize(c, sizeof(*c));
+    b->frozen += cost;
+    return freed > cost ? freed - cost : 0;
+}
+
+size_t editorBufferFreeze(struct editorBuffer *b, int first, int last) {
+    /* Freeze the rows [first, last] that aren't frozen yet, packing the runs of consecutive ones in as few chunks
+    as they fit in. A row longer than EDITOR_CHUNK_BYTES gets a chunk of its own. Returns how many bytes that
+    gave back. */
+    size_t freed = 0;
+    if(first < 0) first = 0;
+    if(last >= b->numrows) last = b->numrows - 1;
+
+    int j = first;
+    while(j <= last) {
+        if(b->row[j].chunk) {
+            j++;
+            continue;
+        }
+        int start = j, raw = 0;
+        while(j <= last && !b->row[j].chunk && (raw == 0 || raw + b->row[j].size + 1 <= EDITOR_CHUNK_BYTES)) {
+            raw += b->row[j].size + 1;
+            j++;
+        }
+        freed += editorChunkFreeze(b, start, j, raw);
+    }
+    return freed;
+}
+
+/*** Row operations ***/
+int editorRowCxToRx(erow *row, int cx) {
+    // convert char position to render position
+    const char *chars = editorRowText(row);
+    int rx = 0;
+    for(int j = 0; j < cx; j++) {
+        if(chars[j] == '\t') {
+            rx += (KILO_TAB_STOP - 1) - (rx % KILO_TAB_STOP);
+        }
+        rx++;
+    }
+
+    return rx;
+}
+
+int editorRowRxToCx(erow *row, int rx) {
+    // convert render position in the row to char position
+    const char *chars = editorRowText(row);
+    int cur_rx = 0;
+    int cx;
+
+    for(cx = 0; cx < row->size; cx++) {
+        if(chars[cx] == '\t') {
+            cur_rx += (KILO_TAB_STOP - 1) - (cur_rx % KILO_TAB_STOP);
+        }
+        cur_rx++;
+
+        if(cur_rx > rx) return cx;
+    }
+    // just in case the caller provided an rx that’s out of range, which shouldn’t happen.
+    return cx;
+}
+
+int editorRowRxToCxCeil(erow *row, int rx) {
+    // like editorRowRxToCx, but a tab that starts before rx is not considered part of the column
+    int cx = editorRowRxToCx(row, rx);
+    if(cx < row->size && editorRowCxToRx(row, cx) < rx) cx++;
+    return cx;
+}
+
+void editorUpdateRender(erow *row) {
+    int tabs = 0;
+    int j;
+    /* The maximum number of characters needed for each tab is 4. row->size already counts 1 for each tab, 
+    so we multiply the number of tabs by 3 and add that to row->size to get the maximum amount of memory 
+    we’ll need for the rendered row.
+    A frozen row is rendered from its chunk, and stays frozen (see editorRowText()).
+    */
+    const char *chars = editorRowText(row);
+    for(j = 0; j < row->size; j++) {
+        if(chars[j] == '\t') tabs++;
+    }
+
+    yateFree(row->render);
+    row->render = yateMalloc(row->size + tabs*(KILO_TAB_STOP-1) + 1);
+
+    int idx = 0;
+    // copy the from chars to render
+    for(j = 0; j < row->size; j++) {
+        if(chars[j] == '\t') {
+            row->render[idx++] = ' ';
+            while(idx % KILO_TAB_STOP != 0) row->render[idx++] = ' ';
+        }
+        else {
+            row->render[idx++] = chars[j];
+        }
+    }
+    row->render[idx] = '\0';
+    row->rsize = idx;
+}
+
+void editorUpdateRow(struct editorBuffer *b, erow *row) {
+    editorUpdateRender(row);
+    editorUpdateSyntax(b, row);
+}
+
+void editorInsertRow(struct editorBuffer *b, int at, char *s, size_t len) {
+    if(at < 0 || at > b->numrows) return;
+
+    b->row = yateRealloc(b->row, sizeof(erow) * (b->numrows + 1));
+    // dest, origin and num_bytes (size of the block to move)
+    memmove(&b->row[at + 1], &b->row[at], sizeof(erow) * (b->numrows - at));
+    // update the index of below rows
+    for (int j = at + 1; j <= b->numrows; j++) b->row[j].idx++;
+
+    b->row[at].idx = at;
+
+    b->row[at].size = len;
+    b->row[at].chars = yateMalloc(len + 1); // reserve the memory for the message
+    memcpy(b->row[at].chars, s, len); // copy the message to chars
+    b->row[at].chars[len] = '\0';
+    b->row[at].rsize = 0;
+    b->row[at].render = NULL;
+    b->row[at].highlight = NULL;
+    b->row[at].hl_open_comment = 0;
+    b->row[at].chunk = NULL;
+    b->row[at].chunk_off = 0;
+    b->numrows++; // a line must be displayed now
+    b->dirty++;
+    b->row[at].gen = ++b->generation;
+    editorNoteInsert(b, at);
+    // the new row is highlighted now if it lands above the watermark, or the whole buffer is highlighted
+    if(at < b->hl_done || (b->hl_done == b->numrows - 1 && !b->hl_loading)) b->hl_done++;
+    editorUpdateRow(b, &b->row[at]);
+}
+
+void editorFreeRow(erow *row) {
+    yateFree(row->render);
+    yateFree(row->chars);
+    yateFree(row->highlight);
+    editorChunkRelease(row->chunk);
+    row->chunk = NULL;
+}
+
+size_t editorRowEvict(erow *row) {
+    /* Make the row cold: free its render and highlight, which are only derived from chars (and the rows above,
+    for the highlighting), to give the memory back. rsize and hl_open_comment stay, so the cursor can still move
+    over the row and the rows below it highlight the same. Returns how many bytes that gave back. */
+    size_t freed = yateUsableSize(row->render, row->rsize + 1) + yateUsableSize(row->highlight, row->rsize);
+    yateFree(row->render);
+    yateFree(row->highlight);
+    row->render = NULL;
+    row->highlight = NULL;
+    return freed;
+}
+
+void editorRowWarm(struct editorBuffer *b, erow *row) {
+    /* Rebuild what editorRowEvict() freed, before the row is drawn. The highlighting only comes back above the
+    watermark: past it, the row waits for editorHighlightStep() like any other. */
+    if(!row->render) editorUpdateRender(row);
+    if(!row->highlight && row->idx < b->hl_done) editorHighlightRow(b, row);
+    b->evicted = 0;
+}
+
+void editorDelRow(struct editorBuffer *b, int at) {
+    if(at < 0 || at >= b->numrows) return;
+    editorFreeRow(&b->row[at]);
+    // dest, origin and num_bytes (size of the block to move, including null char at the end)
+    memmove(&b->row[at], &b->row[at + 1], sizeof(erow) * (b->numrows - at - 1));
+    // update the index of below rows
+    for (int j = at; j < b->numrows - 1; j++) b->row[j].idx--;
+    if(at < b->hl_done) b->hl_done--;
+    b->numrows--;
+    b->dirty++;
+    b->generation++;
+    editorNoteDelete(b, at);
+}
+
+
+void editorRowInsertChar(struct editorBuffer *b, erow *row, int at, int c) {
+    if(at < 0 || at > row->size) at = row->size;
+    editorRowThaw(row);
+    row->chars = yateRealloc(row->chars, row->size + 2); // add 2 because we also have to make room for the null byte
+    // It is like memcpy(), but is safe to use when the source and destination arrays overlap.
+    // dest, origin and num_bytes (size of the block to move, including null char at the end)
+    memmove(&row->chars[at + 1], &row->chars[at], row->size - at + 1);
+    /* Use memmove() to make room for the new character. 
+    We increment the size of the chars array, and then actually assign the character to its position in the array.
+    */
+    row->size++;
+    row->chars[at] = c;
+    editorRowsChanged(b, row->idx, row->idx);
+    editorUpdateRow(b, row);
+}
+
+void editorRowAppendString(struct editorBuffer *b, erow *row, char *s, size_t len) {
+    editorRowThaw(row);
+    row->chars = yateRealloc(row->chars, row->size + len + 1); // reserve space of the new s (string) + null byte
+    memcpy(&row->chars[row->size], s, len); // copy s to the end of chars
+    row->size += len; // update new len
+    row->chars[row->size] = '\0'; // add null byte
+    editorRowsChanged(b, row->idx, row->idx);
+    editorUpdateRow(b, row);
+}
+
+
+void editorRowDelChar(struct editorBuffer *b, erow *row, int at) {
+    /* Deletes a character in a row*/
+    if(at < 0 || at >= row->size) return;
+    editorRowThaw(row);
+    // Use memmove() to overwrite the deleted character with the characters that come after it (the null byte at the end gets included)
+    // dest, origin and num_bytes
+    memmove(&row->chars[at], &row->chars[at + 1], row->size - at);
+    row->size--;
+    editorRowsChanged(b, row->idx, row->idx);
+    editorUpdateRow(b, row);
+}
+
+int editorRowReplaceRx(erow *row, int rx0, int rx1, const char *s, int len) {
+    /* Replace the characters in render columns [rx0, rx1) with s, and rebuild the render once.
+    Rows that are too short to reach rx0 are padded with spaces when there is something to insert,
+    so the text lands in the same column on every row. Returns 1 if the row changed. */
+    int pad = (len && row->rsize < rx0) ? rx0 - row->rsize : 0;
+    int cx0 = pad ? row->size + pad : editorRowRxToCxCeil(row, rx0);
+    int cx1 = pad ? cx0 : editorRowRxToCxCeil(row, rx1);
+    if(cx1 < cx0) cx1 = cx0;
+    if(cx1 == cx0 && len == 0) return 0;
+
+    editorRowThaw(row);
+    if(pad + len > cx1 - cx0) row->chars = yateRealloc(row->chars, row->size + pad + len - (cx1 - cx0) + 1);
+    memset(&row->chars[row->size], ' ', pad);
+    row->size += pad;
+    row->chars[row->size] = '\0';
+    // dest, origin and num_bytes (the tail of the row, including the null byte)
+    memmove(&row->chars[cx0 + len], &row->chars[cx1], row->size - cx1 + 1);
+    memcpy(&row->chars[cx0], s, len);
+    row->size += len - (cx1 - cx0);
+    editorUpdateRender(row);
+    return 1;
+}
+
+
+/*** buffer ***/
+void editorBufferInit(struct editorBuffer *b) {
+    b->numrows = 0;
+    b->row = NULL;
+    b->dirty = 0;
+    b->generation = 0;
+    b->filename = NULL;
+    b->syntax = NULL;
+    b->hl_done = 0;
+    b->hl_lazy = 0;
+    b->hl_loading = 0;
+    b->highlighted = 0;
+    memset(&b->interrupt, 0, sizeof(b->interrupt));
+    b->evicted = 0;
+    memset(b->hot, 0, sizeof(b->hot));
+    b->frozen = 0;
+    b->damaged = 0;
+    memset(b->subscribed, 0, sizeof(b->subscribed));
+    b->subscribers = 0;
+}
+
+void editorBufferFree(struct editorBuffer *b) {
+    for (int j = 0; j < b->numrows; j++) editorFreeRow(&b->row[j]);
+    yateFree(b->row);
+    yateFree(b->filename);
+    int (*check)() = b->interrupt.check; // the front end's, it goes on with the empty buffer
+    editorBufferInit(b);
+    b->interrupt.check = check;
+}
+
+void editorBufferMemory(struct editorBuffer *b, struct editorMemory *m) {
+    /* yateUsableSize() tells how big each block really is, which includes what realloc() rounded up,
+    so this is what the buffer costs and not just the bytes it uses. */
+    m->rows = yateUsableSize(b->row, sizeof(erow) * b->numrows);
+    m->chars = m->render = m->highlight = m->text = 0;
+    m->frozen = b->frozen;
+    for(int j = 0; j < b->numrows; j++) {
+        erow *row = &b->row[j];
+        m->chars += yateUsableSize(row->chars, row->size + 1);
+        m->render += yateUsableSize(row->render, row->rsize + 1);
+        m->highlight += yateUsableSize(row->highlight, row->rsize);
+        m->text += row->size + 1;
+    }
+}
+
+size_t editorBufferEvict(struct editorBuffer *b) {
+    /* Make every row cold (see editorRowEvict()), for a buffer that isn't shown. Returns how many bytes that gave
+    back. The rows are warmed one by one as they are drawn again. */
+    size_t freed = 0;
+    for(int j = 0; j < b->numrows; j++) freed += editorRowEvict(&b->row[j]);
+    b->evicted = 1;
+    return freed;
+}
+
+/*** file I/O ***/
+char *editorRowsToString(struct editorBuffer *b, size_t *buflen) {
+    size_t totlen = 0; // files bigger than 2 GB don't fit in an int
+    for (int j = 0; j < b->numrows; j++) {
+        totlen += b->row[j].size + 1; // plus 1 since we count the end of line after each lines
+    }
+
+    *buflen = totlen;
+    char *buf = yateMalloc(totlen ? totlen : 1);
+    if(buf == NULL) return NULL;
+    char *pointer = buf;
+
+    for (int j = 0; j < b->numrows; j++) {
+        /*memcpy() the contents of each row to the end of the buffer, appending a newline character after each row.
+        */
+        memcpy(pointer, editorRowText(&b->row[j]), b->row[j].size); // frozen rows a chunk at a time
+        pointer += b->row[j].size;
+        *pointer = '\n';
+        pointer++;
+    }
+
+    return buf;
+}
+
+
+int editorOpen(struct editorBuffer *b, char *filename) {
+    yateFree(b->filename);
+    // makes a copy of the given string, allocating the required memory and assuming you will free() that memory
+    b->filename = yateStrdup(filename);
+
+    editorSelectSyntaxHighlight(b);
+
+    FILE *fp = fopen(filename, "r");
+    if(!fp) return -1;
+    traceBegin("editorOpen");
+    b->hl_loading = b->hl_lazy;
+
+    struct stat st;
+    long long size = fstat(fileno(fp), &st) == 0 ? st.st_size : 0; // for the progress, if it gets interrupted
+    int first = b->numrows;
+    int interrupted = 0;
+
+    char *line = NULL;
+    size_t linecap = 0;
+    ssize_t linelen;
+    // getline() is useful for reading lines from a file when we don’t know how much memory to allocate
+    // for each line. It takes care of memory management for you. First, we pass it a null line pointer
+    // and a linecap (line capacity) of 0. That makes it allocate new memory for the next line it reads,
+    // and set line to point to the memory, and set linecap to let you know how much memory it allocated.
+    // Its return value is the length of the line it read, or -1 if it’s at the end of the file
+    while((linelen = getline(&line, &linecap, fp)) != -1) {
+        // strip off the newline or carriage return at the end of the line before copying it into our erow
+        while(linelen > 0 && (line[linelen - 1] == '\n' || line[linelen - 1] == '\r')) {
+            linelen--;
+        }
+
+        editorInsertRow(b, b->numrows, line, linelen);
+        if(((b->numrows - first) & 4095) == 0 && editorInterrupted(b, "Opening", "bytes", ftello(fp), size)) {
+            interrupted = 1;
+            break;
+        }
+    }
+    free(line);
+    b->hl_loading = 0;
+
+    if(interrupted) {
+        /* Half a file can't be edited: saving it would cut the file on disk. Go back to the empty buffer,
+        without a name, the way it was before. Deleting from the end doesn't move any row. */
+        while(b->numrows > first) editorDelRow(b, b->numrows - 1);
+        yateFree(b->filename);
+        b->filename = NULL;
+        b->syntax = NULL;
+        fclose(fp);
+        b->dirty = 0;
+        traceEndArg("rows", 0);
+        errno = EINTR;
+        return -1;
+    }
+    fclose(fp);
+
+    b->dirty = 0;
+    traceEndArg("rows", b->numrows);
+    return 0;
+}
+
+ssize_t editorWriteString(const char *filename, const char *buf, size_t len) {
+    /* Write len bytes of buf to filename. Returns len, or -1 with errno set.
+    It doesn't touch any buffer, so it can run on a worker thread with a snapshot (see editorSave()). */
+    traceBegin("editorWriteString");
+
+    /* We want to create a new file if it doesn’t already exist (O_CREAT), and we want to open it for reading and writing (O_RDWR).
+     * Because we used the O_CREAT flag, we have to pass an extra argument containing the mode (the permissions) the new file
+     * should have. 0644 is the standard permissions you usually want for text files. It gives the owner of the file permission
+     * to read and write the file, and everyone else only gets permission to read the file.
+    */
+    int fd = open(filename, O_RDWR | O_CREAT, 0644);
+    /* sets the file’s size to the specified length. If the file is larger than that, it will cut off any data
+    at the end of the file to make it that length. If the file is shorter, it will add 0 bytes at the end to
+    make it that length.
+    */
+    if (fd != -1) {
+        if(ftruncate(fd, len) != -1) {
+            // a single write() moves at most about 2 GB, so keep going until everything is on disk
+            size_t written = 0;
+            ssize_t nwritten = 0;
+            while(written < len && (nwritten = write(fd, buf + written, len - written)) > 0) {
+                written += nwritten;
+            }
+            if(written == len) {
+                close(fd);
+                traceEndArg("bytes", len);
+                return len;
+            }
+            if(nwritten == 0) errno = EIO;
+        }
+        int saved_errno = errno; // close() must not clobber the error we report
+        close(fd);
+        errno = saved_errno;
+    }
+    traceEnd();
+    return -1;
+}
+
+ssize_t editorWriteFile(struct editorBuffer *b) {
+    /* Write the buffer to b->filename. Returns the number of bytes written, or -1 with errno set. */
+    size_t len;
+    char *buf = editorRowsToString(b, &len);
+    if(buf == NULL) return -1;
+
+    ssize_t written = editorWriteString(b->filename, buf, len);
+    int saved_errno = errno;
+    yateFree(buf);
+    errno = saved_errno;
+    if(written != -1) b->dirty = 0;
+    return written;
+}
+
+/*** find ***/
+int editorFindRow(struct editorBuffer *b, const char *query, int from, int direction, int *rx) {
+    /* Look for query in the rendered rows, starting at the row after `from` in the given direction (1 or -1)
+    and wrapping around the file. Returns the index of the matching row and stores the render position
+    of the match in rx, or returns -1 if there is no match, or the search was interrupted (see editorInterrupted()).
+    Pass from = -1 to search from the top. */
+    int current = from; // index of the current row we are searching
+
+    traceBegin("editorFindRow");
+    for (int i = 0; i < b->numrows; i++) {
+        current += direction;
+        // wrap around
+        if(current == -1) current = b->numrows - 1;
+        else if(current == b->numrows) current = 0;
+
+        if((i & 4095) == 4095 && editorInterrupted(b, "Search", "rows", i, b->numrows)) {
+            traceEndArg("rows", i);
+            return -1;
+        }
+
+        erow *row = &b->row[current];
+        int cold = row->render == NULL; // rendered just for the search, it stays cold (see editorRowEvict())
+        if(cold) editorUpdateRender(row);
+        char *match = strstr(row->render, query); // check if query is a substring of the current row
+        if(match) *rx = match - row->render;
+        if(cold) editorRowEvict(row);
+        if(match) {
+            traceEndArg("rows", i + 1);
+            return current;
+        }
+    }
+    traceEndArg("rows", b->numrows);
+    return -1;
+}
@@ -0,0 +1,173 @@
+#ifndef YATE_CORE_H
+#define YATE_CORE_H
+
+/*** core ***/
+/* The headless core of yate: the text buffer, row operations, syntax highlighting, search and file I/O.
+
+Nothing in here knows about the terminal. Every function works on the struct editorBuffer it is given
+instead of a global, so tests and benchmarks can drive a buffer in-process without a TTY, and several
+buffers can be used at the same time (one per thread, for example). The terminal front end in yate.c
+is just one client of it. It is built as a static library, libyate.a.
+*/
+
+#include <stddef.h>
+#include <sys/types.h>
+
+/*** defines ***/
+
+#define KILO_TAB_STOP 4
+#define EDITOR_CHUNK_BYTES 65536 // the most text frozen together in a chunk, as far as lz.h can look back
+#define EDITOR_HOT_CHUNKS 4 // chunks of a buffer kept decompressed, see editorRowText()
+
+enum editorHighlight { // possible values that the highlight array can contain.
+    HL_NORMAL = 0,
+    HL_COMMENT,
+    HL_MLCOMMENT,
+    HL_KEYWORD1,
+    HL_KEYWORD2,
+    HL_STRING,
+    HL_NUMBER,
+    HL_MATCH
+};
+
+// flag bits
+#define HL_HIGHLIGHT_NUMBERS (1<<0)
+#define HL_HIGHLIGHT_STRINGS (1<<1)
+
+/*** data ***/
+
+struct editorSyntax {
+    char *filetype; // name of the filetype that will be displayed to the user in the status bar
+    char **filematch; // array of strings, where each string contains a pattern to match a filename against
+    char **keywords; // keywords to hightlight
+    char *singleline_comment_start; // each code file could have a different way to start a single-line comment
+    char *multiline_comment_start;
+    char *multiline_comment_end;
+    int flags; // flags is a bit field that will contain flags for whether to highlight numbers and whether to highlight strings for that filetype.
+};
+
+typedef struct errow { // editor row
+    int idx;
+    int size;
+    int rsize; // size of the contents of render
+    int chunk_off; // where the text of a frozen row starts in its chunk
+    char *chars; // NULL while the row is frozen, see editorRowText()
+    char *render; // NULL while the row is cold, see editorRowEvict()
+    unsigned char *highlight; // array to store the highlighting of each line
+    int hl_open_comment; // flag to know if the row is part of an unclosed comment
+    unsigned long long gen; // the generation of the buffer when the text of this row last changed
+    struct editorChunk *chunk; // where the text of a frozen row is, NULL for the others
+} erow;
+
+struct editorChunk { // the chars of consecutive rows, compressed together by editorBufferFreeze()
+    struct editorBuffer *buf; // whose rows they are, for its hot chunks
+    char *data; // compressed, see lz.h
+    int len; // size of data
+    int raw; // size of the text decompressed, every row with its null byte
+    int rows; // rows that are still frozen in it, it's freed with the last one
+    char *hot; // decompressed, while it's one of buf->hot; NULL otherwise
+};
+
+#define EDITOR_SUBSCRIBERS 8
+
+struct editorChanges { // what changed in a buffer since a subscriber last asked, see editorConsumeChanges()
+    int first, last; // rows [first, last] changed, numbered as they are now; nothing did when first > last
+    int shift; // rows inserted minus rows deleted: the rows after `last` used to be `shift` rows higher up
+    int text; // flag, some text changed; without it only the highlighting did
+};
+
+struct editorInterrupt { // how the long loops of the core find out that the user wants them to stop
+    int (*check)(); // set by the front end for each buffer, returns 1 when the user pressed Esc or Ctrl-C
+    long long next_check; // perfNow() time before which check isn't called again
+    int interrupted; // flag, a loop stopped early; the front end clears it once it has told the user
+    const char *what; // which loop, and how far it got
+    const char *unit;
+    long long done, total;
+};
+
+struct editorBuffer { // one instance of the editor's text, everything the core needs to know about it
+    int numrows;
+    erow *row; // must be a pointer in order to save multiple line
+    int dirty; // flag, we call a text buffer “dirty” if it has been modified since opening or saving the file
+    unsigned long long generation; // bumped by every change and never reset, so background jobs can tell their snapshot is stale
+    char *filename;
+    struct editorSyntax *syntax; // NULL when there is no filetype, and no syntax highlighting should be done
+    int hl_done; // rows [0, hl_done) are highlighted, the ones after it wait for editorHighlightStep()
+    int hl_lazy; // flag, editorOpen() leaves the highlighting of the rows it reads to editorHighlightStep()
+    int hl_loading; // flag, set while editorOpen() is reading the rows of a lazy buffer
+    long long highlighted; // how many times a row went through editorHighlightRow(), the perf HUD shows it per key
+    struct editorInterrupt interrupt; // whether the long loops working on this buffer should stop, see editorInterrupted()
+    int evicted; // flag, editorBufferEvict() freed the render and highlight of every row, and none was rebuilt since
+    struct editorChunk *hot[EDITOR_HOT_CHUNKS]; // the chunks decompressed the most recently, the most recent first
+    size_t frozen; // bytes the chunks of the frozen rows hold, hot ones included
+    int damaged; // rows whose frozen text was lost since the front end last told the user, see editorChunkDamaged()
+    struct editorChanges changes[EDITOR_SUBSCRIBERS]; // accumulated for each subscriber until it consumes them
+    int subscribed[EDITOR_SUBSCRIBERS]; // flags, which of changes[] are in use
+    int subscribers; // how many are, so a buffer nobody watches doesn't pay for it
+};
+
+struct editorMemory { // bytes of heap a buffer holds, filled in by editorBufferMemory()
+    size_t rows; // the array of erow itself
+    size_t chars;
+    size_t render;
+    size_t highlight;
+    size_t frozen; // the chunks of the frozen rows, see editorBufferFreeze()
+    size_t text; // the text, as it would be written to disk
+};
+
+
+/*** buffer ***/
+void editorBufferInit(struct editorBuffer *b);
+void editorBufferFree(struct editorBuffer *b);
+void editorBufferMemory(struct editorBuffer *b, struct editorMemory *m);
+size_t editorBufferEvict(struct editorBuffer *b);
+
+/*** cold storage ***/
+const char *editorRowText(erow *row);
+void editorRowThaw(erow *row);
+size_t editorBufferFreeze(struct editorBuffer *b, int first, int last);
+
+/*** changes ***/
+int editorSubscribe(struct editorBuffer *b);
+void editorUnsubscribe(struct editorBuffer *b, int id);
+int editorConsumeChanges(struct editorBuffer *b, int id, struct editorChanges *c);
+void editorRowsChanged(struct editorBuffer *b, int first, int last);
+
+/*** interruption ***/
+int editorInterrupted(struct editorBuffer *b, const char *what, const char *unit, long long done, long long total);
+
+/*** syntax highlighting ***/
+int is_separator(int c);
+int editorHighlightRow(struct editorBuffer *b, erow *row);
+void editorUpdateSyntax(struct editorBuffer *b, erow *row);
+void editorUpdateSyntaxRange(struct editorBuffer *b, int top, int bottom);
+void editorSelectSyntaxHighlight(struct editorBuffer *b);
+void editorHighlightUpTo(struct editorBuffer *b, int at);
+int editorHighlightStep(struct editorBuffer *b, long long deadline);
+
+/*** row operations ***/
+int editorRowCxToRx(erow *row, int cx);
+int editorRowRxToCx(erow *row, int rx);
+int editorRowRxToCxCeil(erow *row, int rx);
+void editorUpdateRender(erow *row);
+void editorUpdateRow(struct editorBuffer *b, erow *row);
+void editorInsertRow(struct editorBuffer *b, int at, char *s, size_t len);
+void editorFreeRow(erow *row);
+size_t editorRowEvict(erow *row);
+void editorRowWarm(struct editorBuffer *b, erow *row);
+void editorDelRow(struct editorBuffer *b, int at);
+void editorRowInsertChar(struct editorBuffer *b, erow *row, int at, int c);
+void editorRowAppendString(struct editorBuffer *b, erow *row, char *s, size_t len);
+void editorRowDelChar(struct editorBuffer *b, erow *row, int at);
+int editorRowReplaceRx(erow *row, int rx0, int rx1, const char *s, int len);
+
+/*** file I/O ***/
+char *editorRowsToString(struct editorBuffer *b, size_t *buflen);
+int editorOpen(struct editorBuffer *b, char *filename);
+ssize_t editorWriteString(const char *filename, const char *buf, size_t len);
+ssize_t editorWriteFile(struct editorBuffer *b);
+
+/*** find ***/
+int editorFindRow(struct editorBuffer *b, const char *query, int from, int direction, int *rx);
+
+#endif
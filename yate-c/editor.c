@@ -0,0 +1,2215 @@
+/*** includes ***/
+
+#define _DEFAULT_SOURCE
+#define _BSD_SOURCE
+#define _GNU_SOURCE
+
+#include <ctype.h>
+#include <errno.h>
+#ifdef __GLIBC__
+#include <malloc.h> // mallinfo2() and malloc_trim()
+#endif
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "alloc.h"
+#include "editor.h"
+#include "idle.h"
+#include "pool.h"
+#include "trace.h"
+
+/*** data ***/
+struct editorConfig E;
+
+/*** terminal ***/
+void die(const char *s) {
+    // reset screen
+    if(E.io.write) {
+        E.io.write("\x1b[2J\x1b[H", 7); // clear scren and relocate cursor position, in one frame
+    }
+
+    /*Most C library functions that fail will set the global errno variable to indicate what the error was. 
+    perror() looks at the global errno variable and prints a descriptive error message for it.
+
+    It also prints the string given to it before it prints the error message
+    */
+    perror(s);
+    exit(1);
+}
+
+
+int editorReadKey() {
+    /* Wait for one keypress, and return it */
+    int nread;
+    char c;
+
+    editorFrameWait(); // the input stopped: show where it got
+    editorIdle(); // make use of the time until the key arrives
+    while((nread = E.io.read(&c, 1)) != 1) {
+        if(nread == -1 && errno != EAGAIN && errno != EINTR) die("read");
+        int rows, cols;
+        if(E.io.resized && E.io.resized(&rows, &cols)) {
+            editorResize(rows, cols);
+            editorRefreshScreen();
+        }
+        else if(poolHasCompleted()) editorRefreshScreen(); // show what a background job did, like a save
+        else if(editorOutputCaughtUp()) editorRefreshScreen(); // the slow link caught up, see editorOutputCheck()
+        else if(editorMemoryCheck(0)) editorRefreshScreen(); // memory is short, see the memory budget section
+    }
+
+    // the wait for the first byte is not part of the span, only reading the rest of the sequence and decoding it
+    traceBegin("editorDecodeKey");
+    int key = editorDecodeKey(c);
+    traceEndArg("key", key);
+    return key;
+}
+
+int editorDecodeKey(char c) {
+    /* Turn the first byte of a keypress into a key, reading the rest of the escape sequence if there is one */
+    //printf("'%c'", c);
+
+    // process arrow keys
+    if(c == '\x1b') {
+        char seq[3];
+
+        if(E.io.read(&seq[0], 1) != 1) return '\x1b';
+        if(E.io.read(&seq[1], 1) != 1) return '\x1b';
+
+        if(seq[0] == '[') {
+            // mapping to be able to move the cursor with narrow keys
+            if(seq[1] >= '0' && seq[1] <= '9') {
+                if(E.io.read(&seq[2], 1) != 1) return '\x1b';
+                if(seq[2] == '~') {
+                    switch(seq[1]) {
+                        case '1': return HOME_KEY;
+                        case '3': return DEL_KEY;
+                        case '4': return END_KEY;
+                        case '5': return PAGE_UP;
+                        case '6': return PAGE_DOWN;
+                        case '7': return HOME_KEY;
+                        case '8': return END_KEY;
+                    }
+                }
+            }
+            else {
+                switch(seq[1]) {
+                    case 'A': return ARROW_UP;
+                    case 'B': return ARROW_DOWN;
+                    case 'C': return ARROW_RIGHT;
+                    case 'D': return ARROW_LEFT;
+                    case 'H': return HOME_KEY;
+                    case 'F': return END_KEY;
+                }
+            }
+        }
+        else if(seq[0] == 'O') {
+            switch(seq[1]) {
+                case 'H': return HOME_KEY;
+                case 'F': return END_KEY;
+            }
+        }
+
+        return '\x1b';
+    }
+
+    return c;
+}
+
+/*** syntax highlighting ***/
+int editorSyntaxToColor(int hl) {
+    /***maps values in hl to the actual ANSI color codes we want to draw them with.*/
+    switch (hl) {
+        case HL_COMMENT: 
+        case HL_MLCOMMENT: return 36; // cyan
+        case HL_KEYWORD1: return 33; // yellow
+        case HL_KEYWORD2: return 32; // green
+        case HL_STRING: return 35; // magenta
+        case HL_NUMBER: return 31; // red
+        case HL_MATCH: return 34; // blue
+        default: return 37; // white
+    }
+}
+
+/*** Editor Operations ***/
+void editorInsertChar(int c) {
+    traceBegin("editorInsertChar");
+    if(E.cy == E.buf->numrows) { // if we are at the end of the file, add an extra row to write there
+        editorInsertRow(E.buf, E.buf->numrows, "", 0);
+    }
+    editorRowInsertChar(E.buf, &E.buf->row[E.cy], E.cx, c);
+    E.cx++;
+    traceEnd();
+}
+
+
+void editorInsertNewLine() {
+    traceBegin("editorInsertNewLine");
+    if(E.cx == 0) {
+        editorInsertRow(E.buf, E.cy, "", 0);
+    }
+    else {
+        erow *row = &E.buf->row[E.cy];
+        editorRowThaw(row);
+        editorInsertRow(E.buf, E.cy + 1, &row->chars[E.cx], row->size - E.cx);
+        row = &E.buf->row[E.cy];
+        row->size = E.cx;
+        row->chars[row->size] = '\0';
+        editorRowsChanged(E.buf, E.cy, E.cy);
+        editorUpdateRow(E.buf, row);
+    }
+    E.cy++;
+    E.cx = 0;
+    traceEnd();
+}
+
+
+void editorDelChar() {
+    /* If the cursor’s past the end of the file, then there is nothing to delete, and we return.
+    Otherwise, we get the erow the cursor is on, and if there is a character to the left 
+    of the cursor, we delete it and move the cursor one to the left.
+    */
+    if(E.cy == E.buf->numrows) return;
+    // unable to get "up" the current row
+    if(E.cx == 0 && E.cy == 0) return; 
+
+    traceBegin("editorDelChar");
+    erow *row = &E.buf->row[E.cy];
+    if(E.cx > 0) {
+        editorRowDelChar(E.buf, row, E.cx - 1);
+        E.cx--;
+    }
+    // beggining of the line, we want to get "up" the row and concat the content with the previous one
+    else {
+        E.cx = E.buf->row[E.cy - 1].size;
+        editorRowThaw(row);
+        editorRowAppendString(E.buf, &E.buf->row[E.cy - 1], row->chars, row->size);
+        editorDelRow(E.buf, E.cy);
+        E.cy--;
+    }
+    traceEnd();
+}
+
+
+/*** block selection ***/
+/* A block selection is the rectangle between the anchor (E.block_cy, E.block_rx) and the cursor.
+Columns are render columns, so tabs line up the way they are displayed, and the right edge is exclusive:
+when the anchor and the cursor are in the same column, the block is a zero-width column cursor that
+inserts or deletes the same thing in every row.
+
+Every block operation is batched: each row's chars are changed with a single memmove, its render is
+rebuilt once, and the syntax of the whole range is updated in a single pass at the end.
+*/
+int editorCursorRx() {
+    return (E.cy < E.buf->numrows) ? editorRowCxToRx(&E.buf->row[E.cy], E.cx) : 0;
+}
+
+void editorBlockBounds(int *top, int *bottom, int *left, int *right) {
+    int rx = editorCursorRx();
+    *top = E.block_cy < E.cy ? E.block_cy : E.cy;
+    *bottom = E.block_cy < E.cy ? E.cy : E.block_cy;
+    *left = E.block_rx < rx ? E.block_rx : rx;
+    *right = E.block_rx < rx ? rx : E.block_rx;
+    if(*bottom >= E.buf->numrows) *bottom = E.buf->numrows - 1;
+}
+
+void editorBlockMoveTo(int rx) {
+    // collapse the block into a zero-width column at rx, keeping the rows it spans
+    E.block_rx = rx;
+    if(E.cy < E.buf->numrows) E.cx = editorRowRxToCxCeil(&E.buf->row[E.cy], rx);
+}
+
+void editorBlockToggle() {
+    if(E.block) {
+        E.block = 0;
+        editorSetStatusMessage("");
+        return;
+    }
+    E.block = 1;
+    E.block_cy = E.cy;
+    E.block_rx = editorCursorRx();
+    editorSetStatusMessage("-- BLOCK -- move to select, type to insert, Ctrl-Y yank, Ctrl-X cut, ESC to end");
+}
+
+void editorBlockReplace(int top, int bottom, int rx0, int rx1, const char *s, int len) {
+    int changed = 0;
+    traceBegin("editorBlockReplace");
+    for(int y = top; y <= bottom; y++) {
+        changed |= editorRowReplaceRx(&E.buf->row[y], rx0, rx1, s, len);
+    }
+    if(changed) {
+        editorRowsChanged(E.buf, top, bottom);
+        editorUpdateSyntaxRange(E.buf, top, bottom);
+    }
+    traceEndArg("rows", bottom - top + 1);
+}
+
+void editorBlockInsertChar(int c) {
+    int top, bottom, left, right;
+    editorBlockBounds(&top, &bottom, &left, &right);
+    if(top > bottom) return;
+
+    char ch = c;
+    editorBlockReplace(top, bottom, left, right, &ch, 1);
+    editorBlockMoveTo(left + 1);
+}
+
+void editorBlockDelete(int key) {
+    int top, bottom, left, right;
+    editorBlockBounds(&top, &bottom, &left, &right);
+    if(top > bottom) return;
+
+    if(right == left) { // zero-width column: behave like backspace or delete on every row
+        if(key == DEL_KEY) right++;
+        else if(left > 0) left--;
+        else return;
+    }
+    editorBlockReplace(top, bottom, left, right, "", 0);
+    editorBlockMoveTo(left);
+}
+
+void editorBlockFreeClip() {
+    for(int j = 0; j < E.cliprows; j++) yateFree(E.clip[j]);
+    yateFree(E.clip);
+    yateFree(E.cliplen);
+    E.clip = NULL;
+    E.cliplen = NULL;
+    E.cliprows = 0;
+}
+
+void editorBlockYank() {
+    int top, bottom, left, right;
+    editorBlockBounds(&top, &bottom, &left, &right);
+    if(top > bottom || right == left) return;
+
+    editorBlockFreeClip();
+    E.cliprows = bottom - top + 1;
+    E.clip = yateMalloc(sizeof(char *) * E.cliprows);
+    E.cliplen = yateMalloc(sizeof(int) * E.cliprows);
+
+    for(int y = top; y <= bottom; y++) {
+        erow *row = &E.buf->row[y];
+        int cx0 = editorRowRxToCxCeil(row, left);
+        int cx1 = editorRowRxToCxCeil(row, right);
+        int len = cx1 - cx0;
+        // pad short rows with spaces, so pasting the block keeps it rectangular
+        int width = editorRowCxToRx(row, cx1) - editorRowCxToRx(row, cx0);
+        int pad = (width < right - left) ? (right - left) - width : 0;
+
+        char *s = yateMalloc(len + pad);
+        memcpy(s, &editorRowText(row)[cx0], len);
+        memset(&s[len], ' ', pad);
+        E.clip[y - top] = s;
+        E.cliplen[y - top] = len + pad;
+    }
+    editorSetStatusMessage("Yanked block of %d rows", E.cliprows);
+}
+
+void editorBlockCut() {
+    int top, bottom, left, right;
+    editorBlockBounds(&top, &bottom, &left, &right);
+    if(top > bottom || right == left) return;
+
+    editorBlockYank();
+    editorBlockReplace(top, bottom, left, right, "", 0);
+    editorBlockMoveTo(left);
+}
+
+void editorBlockPaste() {
+    if(E.cliprows == 0) return;
+    int rx = editorCursorRx();
+    int top = E.cy;
+    traceBegin("editorBlockPaste");
+
+    // make room at the end of the file for the rows that don't exist yet
+    while(E.buf->numrows < top + E.cliprows) editorInsertRow(E.buf, E.buf->numrows, "", 0);
+
+    for(int j = 0; j < E.cliprows; j++) {
+        editorRowReplaceRx(&E.buf->row[top + j], rx, rx, E.clip[j], E.cliplen[j]);
+    }
+    editorRowsChanged(E.buf, top, top + E.cliprows - 1);
+    editorUpdateSyntaxRange(E.buf, top, top + E.cliprows - 1);
+    traceEndArg("rows", E.cliprows);
+}
+
+
+/*** file I/O ***/
+/* Saving runs on the worker pool (see pool.h), so a big file doesn't freeze the keyboard while it's written.
+The rows are turned into one string on the main thread, which is the only part that has to look at the buffer,
+and the worker writes that snapshot. When the job completes, the buffer is only marked clean if nothing was
+edited in the meantime: the snapshot remembers the generation of the buffer (see core.h) it was taken at.
+A save requested while another one of the same buffer is running is done right after it, with the newer contents.
+*/
+struct saveJob {
+    struct poolJob job;
+    int file; // in E.files, whose saving and save_again flags it goes with
+    struct editorBuffer *buf;
+    unsigned long long generation; // of the buffer when the snapshot was taken
+    char *filename;
+    char *text;
+    size_t len;
+    ssize_t written;
+    int error;
+};
+
+void editorSaveRun(struct poolJob *job) {
+    struct saveJob *save = job->ctx;
+    save->written = editorWriteString(save->filename, save->text, save->len);
+    save->error = errno;
+}
+
+void editorSaveDone(struct poolJob *job) {
+    struct saveJob *save = job->ctx;
+    int file = save->file;
+    E.files[file].saving = 0;
+    if(save->written != -1) {
+        if(save->buf->generation == save->generation) save->buf->dirty = 0;
+        editorSetStatusMessage("%zd bytes written to disk", save->written);
+    } else {
+        editorSetStatusMessage("Can't save! I/O error: %s", strerror(save->error));
+    }
+    yateFree(save->text);
+    yateFree(save->filename);
+    yateFree(save);
+
+    if(E.files[file].save_again) { // that buffer, whichever is shown now
+        E.files[file].save_again = 0;
+        editorSaveFile(file);
+    }
+}
+
+void editorSaveAs(char *filename) {
+    if(filename == NULL) {
+        editorSetStatusMessage("Save aborted");
+        return;
+    }
+    E.buf->filename = filename;
+    editorSelectSyntaxHighlight(E.buf);
+    editorSave();
+}
+
+void editorSave() {
+    if(E.buf->filename == NULL) {
+        editorPromptStart("Save as: %s (ESC to cancel)", NULL, editorSaveAs);
+        return;
+    }
+    editorSaveFile(E.file);
+}
+
+void editorSaveFile(int i) {
+    // save E.files[i], which has a name
+    struct editorFile *f = &E.files[i];
+    if(f->saving) {
+        // two writers on one file would interleave; write the newest contents once this one is done
+        f->save_again = 1;
+        editorSetStatusMessage("Saving...");
+        return;
+    }
+
+    struct saveJob *save = yateMalloc(sizeof(struct saveJob));
+    save->file = i;
+    save->buf = f->buf;
+    save->generation = f->buf->generation;
+    save->text = editorRowsToString(f->buf, &save->len);
+    save->filename = yateStrdup(f->buf->filename);
+    save->written = -1;
+    save->error = 0;
+    save->job.run = editorSaveRun;
+    save->job.complete = editorSaveDone;
+    save->job.token = NULL;
+    save->job.ctx = save;
+
+    f->saving = 1;
+    editorSetStatusMessage("Saving...");
+    poolSubmit(&save->job);
+}
+
+/*** find ***/
+// the highlighting of the row the current match is on, from before the match was painted over it
+int saved_hl_line;
+char *saved_hl = NULL;
+
+struct matchCount { // an idle task that counts the matches of the search query in the whole file
+    char *query;
+    int row; // the next row to look at
+    int count;
+};
+int match_task = 0; // id of the running match count, 0 when there is none
+// the query of the running or the last completed count, and the buffer it counts in, as it was then
+char *match_counted = NULL;
+struct editorBuffer *match_buf;
+unsigned long long match_generation;
+
+int editorMatchCountStep(void *ctx, long long deadline) {
+    struct matchCount *mc = ctx;
+    size_t qlen = strlen(mc->query);
+    while(mc->row < E.buf->numrows) {
+        erow *row = &E.buf->row[mc->row++];
+        int cold = row->render == NULL; // rendered just for the count, see editorRowEvict()
+        if(cold) editorUpdateRender(row);
+        for(char *p = strstr(row->render, mc->query); p; p = strstr(p + qlen, mc->query)) mc->count++;
+        if(cold) editorRowEvict(row);
+        if((mc->row & 63) == 0 && perfNow() >= deadline) return 1;
+    }
+    E.search_matches = mc->count;
+    E.repaint = 1;
+    return 0;
+}
+
+void editorMatchCountDone(void *ctx, int cancelled) {
+    struct matchCount *mc = ctx;
+    yateFree(mc->query);
+    yateFree(mc);
+    match_task = 0;
+    if(cancelled) { // only a count that went to the end can be kept
+        yateFree(match_counted);
+        match_counted = NULL;
+    }
+}
+
+void editorMatchCount(char *query) {
+    /* (Re)start counting the matches of query, in the background. Nothing to do if it is already being counted, or
+    was counted in the buffer as it is now: the arrows of the search prompt don't change the count. */
+    if(match_counted && query && !strcmp(match_counted, query) && match_buf == E.buf
+        && match_generation == E.buf->generation) return;
+    idleCancel(match_task);
+    yateFree(match_counted);
+    match_counted = NULL;
+    E.search_matches = -1;
+    if(query == NULL || query[0] == '\0') return;
+
+    struct matchCount *mc = yateMalloc(sizeof(struct matchCount));
+    mc->query = yateStrdup(query);
+    mc->row = 0;
+    mc->count = 0;
+    match_counted = yateStrdup(query);
+    match_buf = E.buf;
+    match_generation = E.buf->generation;
+    match_task = idleAdd("editorMatchCount", 0, editorMatchCountStep, editorMatchCountDone, mc);
+    if(!match_task) editorMatchCountDone(mc, 1);
+}
+
+void editorFindCallback(char *query, int key) {
+    // declare variables to support advance to the next or previous match in the file
+    static int last_match = -1; // contain the index of the row that the last match was on, or -1 if there was no last match
+    static int direction = 1; // store the direction of the search: 1 for searching forward, and -1 for searching backward.
+
+    if(saved_hl) {
+        // unless the row went cold since (see editorRowEvict()), then it's highlighted again when it's drawn
+        erow *row = &E.buf->row[saved_hl_line];
+        if(row->highlight) memcpy(row->highlight, saved_hl, row->rsize);
+        yateFree(saved_hl);
+        saved_hl = NULL;
+    }
+
+    if(key == '\r' || key == '\x1b') {
+        last_match = -1;
+        direction = 1;
+        editorMatchCount(NULL);
+        return;
+    }
+    else if(key == ARROW_RIGHT || key == ARROW_DOWN) direction = 1;
+    else if(key == ARROW_LEFT  || key == ARROW_UP) direction = -1;
+    else {
+        last_match = -1;
+        direction = 1;
+    }
+
+    if(last_match == -1) direction = 1;
+    editorMatchCount(query);
+
+    int rx;
+    int current = editorFindRow(E.buf, query, last_match, direction, &rx);
+    if(current != -1) {
+        editorHighlightUpTo(E.buf, current); // the match may be past the highlight watermark
+        erow *row = &E.buf->row[current];
+        editorRowWarm(E.buf, row);
+        last_match = current;
+        E.cy = current;
+        E.cx = editorRowRxToCx(row, rx);
+        /***  we set E.rowoff so that we are scrolled to the very bottom of the file, which will cause 
+         * editorScroll() to scroll upwards at the next screen refresh so that the matching line will be at 
+         * the very top of the screen 
+        ***/
+        E.rowoff = E.buf->numrows;
+        // save current highlight
+        saved_hl_line = current;
+        saved_hl = yateMalloc(row->rsize);
+        memcpy(saved_hl, row->highlight, row->rsize);
+
+        // highlight match search
+        memset(&row->highlight[rx], HL_MATCH, strlen(query));
+    }
+}
+
+// where the cursor was when the search started, to go back there when the user presses Escape
+struct {
+    int cx, cy, coloff, rowoff;
+} find_saved;
+
+void editorFindDone(char *query) {
+    if(query) {
+        yateFree(query);
+        return;
+    }
+    E.cx = find_saved.cx;
+    E.cy = find_saved.cy;
+    E.coloff = find_saved.coloff;
+    E.rowoff = find_saved.rowoff;
+}
+
+void editorFind() {
+    /*** When the user presses Escape to cancel a search, we want the cursor to go back to where it was when 
+     * they started the search*/
+    find_saved.cx = E.cx;
+    find_saved.cy = E.cy;
+    find_saved.coloff = E.coloff;
+    find_saved.rowoff = E.rowoff;
+
+    editorPromptStart("Search: %s (Use ESC/Arrows/Enter)", editorFindCallback, editorFindDone);
+}
+
+
+/*** memory report ***/
+/* Where the memory of a session goes. Every block is measured with yateUsableSize(), and the heap as a
+whole with glibc's mallinfo2(): the free bytes it keeps inside its arenas, compared to the arena size, are a
+rough estimate of the fragmentation. */
+void editorFormatBytes(char *buf, size_t bufsize, double bytes) {
+    if(bytes >= 1024 * 1024 * 1024) snprintf(buf, bufsize, "%.1fG", bytes / (1024 * 1024 * 1024));
+    else if(bytes >= 1024 * 1024) snprintf(buf, bufsize, "%.1fM", bytes / (1024 * 1024));
+    else if(bytes >= 1024) snprintf(buf, bufsize, "%.1fK", bytes / 1024);
+    else snprintf(buf, bufsize, "%.0fB", bytes);
+}
+
+size_t editorClipMemory() {
+    size_t total = yateUsableSize(E.clip, sizeof(char *) * E.cliprows) + yateUsableSize(E.cliplen, sizeof(int) * E.cliprows);
+    for(int j = 0; j < E.cliprows; j++) total += yateUsableSize(E.clip[j], E.cliplen[j]);
+    return total;
+}
+
+void editorMemoryReport(FILE *fp) {
+    /* The full breakdown, one line per subsystem. */
+    struct editorMemory m;
+    editorBufferMemory(E.buf, &m);
+    size_t search = yateUsableSize(saved_hl, E.buf->row[saved_hl_line].rsize);
+    size_t clip = editorClipMemory();
+    size_t total = sizeof(struct editorBuffer) + m.rows + m.chars + m.render + m.highlight + m.frozen + search + clip +
+        E.frame_peak;
+    int rows = E.buf->numrows ? E.buf->numrows : 1;
+
+    fprintf(fp, "yate memory report: %s, %d rows, %zu bytes of text\n",
+        E.buf->filename ? E.buf->filename : "[No Name]", E.buf->numrows, m.text);
+    fprintf(fp, "  %-16s %14s %12s\n", "", "bytes", "bytes/row");
+    fprintf(fp, "  %-16s %14zu %12.1f\n", "row array", m.rows, (double) m.rows / rows);
+    fprintf(fp, "  %-16s %14zu %12.1f\n", "chars", m.chars, (double) m.chars / rows);
+    fprintf(fp, "  %-16s %14zu %12.1f\n", "render", m.render, (double) m.render / rows);
+    fprintf(fp, "  %-16s %14zu %12.1f\n", "highlight", m.highlight, (double) m.highlight / rows);
+    fprintf(fp, "  %-16s %14zu %12.1f\n", "frozen", m.frozen, (double) m.frozen / rows);
+    fprintf(fp, "  %-16s %14zu\n", "search", search);
+    fprintf(fp, "  %-16s %14zu\n", "block clipboard", clip);
+    fprintf(fp, "  %-16s %14d\n", "frame (peak)", E.frame_peak);
+    fprintf(fp, "  %-16s %14zu %12.1f\n", "total", total, (double) total / rows);
+    for(int i = 0; i < E.nfiles; i++) { // the buffers that aren't shown, see the buffers section
+        struct editorFile *f = &E.files[i];
+        if(editorFileShown(i) || f->path) continue;
+        struct editorMemory o;
+        editorBufferMemory(f->buf, &o);
+        fprintf(fp, "  hidden buffer %-20.20s %14zu bytes%s\n", f->buf->filename ? f->buf->filename : "[No Name]",
+            o.rows + o.chars + o.render + o.highlight + o.frozen, f->buf->evicted ? ", evicted" : "");
+    }
+    fprintf(fp, "  overhead: %.2fx the size of the text\n", m.text ? (double) total / m.text : 0);
+#ifdef __GLIBC__
+    struct mallinfo2 mi = mallinfo2();
+    fprintf(fp, "  heap: %zu bytes in arenas, %zu in use, %zu free (%.1f%% fragmentation), %zu mmapped\n",
+        mi.arena, mi.uordblks, mi.fordblks, mi.arena ? 100.0 * mi.fordblks / mi.arena : 0.0, mi.hblkhd);
+#endif
+}
+
+void editorMemorySummary() {
+    /* The short version of the report, for the status bar. */
+    struct editorMemory m;
+    editorBufferMemory(E.buf, &m);
+    size_t other = sizeof(struct editorBuffer) + yateUsableSize(saved_hl, E.buf->row[saved_hl_line].rsize) + editorClipMemory() + E.frame_peak;
+    size_t total = m.rows + m.chars + m.render + m.highlight + m.frozen + other;
+    char t[16], c[16], z[16], r[16], h[16], a[16], o[16];
+    editorFormatBytes(t, sizeof(t), total);
+    editorFormatBytes(c, sizeof(c), m.chars);
+    editorFormatBytes(z, sizeof(z), m.frozen);
+    editorFormatBytes(r, sizeof(r), m.render);
+    editorFormatBytes(h, sizeof(h), m.highlight);
+    editorFormatBytes(a, sizeof(a), m.rows);
+    editorFormatBytes(o, sizeof(o), other);
+    editorSetStatusMessage("mem %s: chars %s%s%s render %s hl %s rows %s +%s, %.1fx, %.0fB/row", t, c,
+        m.frozen ? "+" : "", m.frozen ? z : "", r, h, a, o,
+        m.text ? (double) total / m.text : 0, (double) total / (E.buf->numrows ? E.buf->numrows : 1));
+}
+
+/*** append buffer ***/
+/* It would be better to do one big write(), to make sure the whole screen updates at once.
+Otherwise there could be small unpredictable pauses between write()’s, which would cause an
+annoying flicker effect.
+
+We want to replace all our write() calls with code that appends the string to a buffer, 
+and then write() this buffer out at the end.
+*/
+struct abuf {
+    char* b;
+    int len;
+    int cap; // bytes allocated at b, it grows by doubling so a frame doesn't cost a realloc() per append
+};
+// An append buffer consists of a pointer to our buffer in memory, and a length
+#define ABUF_INIT {NULL, 0, 0}
+
+int abReserve(struct abuf *ab, int cap) {
+    // make room for cap bytes in all, returns 0 if there isn't memory for them
+    if(cap <= ab->cap) return 1;
+    char *new = yateRealloc(ab->b, cap);
+    if(new == NULL) return 0;
+    ab->b = new;
+    ab->cap = cap;
+    return 1;
+}
+
+void abAppend(struct abuf *ab, const char *s, int len) {
+    // make sure we allocate enough memory to hold the new string.
+    if(ab->len + len > ab->cap && !abReserve(ab, ab->len + len > ab->cap * 2 ? ab->len + len : ab->cap * 2)) return;
+
+    /* copy the string s after the end of the current data in the buffer, and we update the length of the abuf
+    to the new value */
+    memcpy(&ab->b[ab->len], s, len);
+    ab->len += len;
+}
+
+void abFree(struct abuf *ab) {
+    yateFree(ab->b);
+}
+
+/** output ***/
+void editorAppendRun(struct abuf *ab, char c, int n, int plain) {
+    /* Append c n times. Terminals that can are told to do the repeating themselves, which saves most of the bytes
+    of indentation, rules like ======, and padding on a slow link:
+        REP (<esc>[nb) repeats the character that was just printed n more times,
+        ECH (<esc>[nX) blanks n cells from the cursor, and CUF (<esc>[nC) moves over them, for spaces.
+    ECH blanks with the current colors, so it's only used for plain spaces, outside of the reverse video of a
+    selection (plain is 0 there). Either is only used when it's shorter than the run itself. */
+    char buf[32];
+    int len = 0;
+    if(E.term_rep && n > 1) {
+        len = snprintf(buf, sizeof(buf), "%c\x1b[%db", c, n - 1);
+    }
+    else if(E.term_ech && c == ' ' && plain && n > 1) {
+        len = snprintf(buf, sizeof(buf), "\x1b[%dX\x1b[%dC", n, n);
+    }
+    if(len > 0 && len < n) {
+        abAppend(ab, buf, len);
+        return;
+    }
+
+    char run[64];
+    memset(run, c, n < (int) sizeof(run) ? n : (int) sizeof(run));
+    while(n > 0) {
+        int chunk = n < (int) sizeof(run) ? n : (int) sizeof(run);
+        abAppend(ab, run, chunk);
+        n -= chunk;
+    }
+}
+
+void editorScroll() {
+    E.rx = E.cx;
+    if (E.cy < E.buf->numrows) {
+        E.rx = editorRowCxToRx(&E.buf->row[E.cy], E.cx);
+    }
+
+    /* The first if statement checks if the cursor is above the visible window,
+    and if so, scrolls up to where the cursor is. The second if statement checks if the cursor
+    is past the bottom of the visible window, and contains slightly more complicated arithmetic 
+    because E.rowoff refers to what’s at the top of the screen.
+    */
+    if(E.cy < E.rowoff) {
+        E.rowoff = E.cy;
+    }
+    if(E.cy >= E.rowoff + E.screenrows) {
+        E.rowoff = E.cy - E.screenrows + 1;
+    }
+    // horizontal scrolling
+    if(E.rx < E.coloff) {
+        E.coloff = E.rx;
+    }
+    if(E.rx >= E.coloff + E.screencols) {
+        E.coloff = E.rx - E.screencols + 1;
+    }
+}
+
+struct editorBlockRect { // the block selection a window shows, in rows and render columns
+    int top, bottom, left, right;
+};
+
+struct editorBlockRect *editorWindowBlock(struct editorWindow *w, struct editorBlockRect *r) {
+    /* Fill r with the block selection shown in w and return it, or return NULL when w shows none. It's for the main
+    thread: the column of the cursor comes from its row, which may be frozen (see editorRowText()). */
+    if(!E.block || w != &E.windows[E.window]) return NULL;
+    editorBlockBounds(&r->top, &r->bottom, &r->left, &r->right);
+    return r;
+}
+
+void editorDrawRows(struct abuf *ab, struct editorWindow *w, int first, int last, struct editorBlockRect *block) {
+    /* Draw the rows [first, last] of window w, with the block selection from editorWindowBlock(). A window as wide
+    as the screen starts where the cursor is, and goes from one row to the next with \r\n. Any other one puts the
+    cursor at the start of each row, and can't clear to the end of the line, which would erase its neighbour: it
+    pads with blanks, then draws its separator. */
+    struct editorBuffer *buf = E.files[w->file].buf;
+    int stream = w->left == 0 && w->cols == E.textcols;
+    int y;
+    int block_top = 0, block_bottom = -1, block_left = 0, block_right = 0;
+    if(block) {
+        block_top = block->top;
+        block_bottom = block->bottom;
+        block_left = block->left;
+        block_right = block->right;
+    }
+    for(y = first; y <= last; y++) {
+        int filerow = y + w->rowoff;
+        int width = 0; // the columns drawn so far
+        if(!stream) {
+            char move[32];
+            abAppend(ab, move, snprintf(move, sizeof(move), "\x1b[%d;%dH", w->top + y + 1, w->left + 1));
+        }
+        if(filerow >= buf->numrows) { // check whether we are currently drawing a row that is part of the text buffer
+            if(buf->numrows == 0 && y == w->rows / 3) {
+                // write a WELCOME message
+                char welcome[80];
+                /*We use the welcome buffer and snprintf() to interpolate our YATE_VERSION string into 
+                the welcome message*/
+                int welcomelen = snprintf(welcome, sizeof(welcome), "Yate Editor -- version %s", YATE_VERSION);
+
+                if(welcomelen > w->cols) welcomelen = w->cols;
+
+                // center the message
+                int padding = (w->cols - welcomelen) / 2;
+                width = padding + welcomelen;
+                if(padding) {
+                    abAppend(ab, "~", 1);
+                    padding--;
+                }
+                if(padding > 0) editorAppendRun(ab, ' ', padding, 1);
+
+                abAppend(ab, welcome, welcomelen);
+            }
+            else {
+                // write(STDOUT_FILENO, "~", 1); // write tilde for each visible row
+                abAppend(ab, "~", 1);
+                width = 1;
+            }
+        }
+        else {
+            // render columns of the block selection on this row, if any (zero-width blocks show one column)
+            int sel_from = -1, sel_to = -1;
+            if(E.block && filerow >= block_top && filerow <= block_bottom) {
+                sel_from = block_left - w->coloff;
+                sel_to = (block_right > block_left ? block_right : block_left + 1) - w->coloff;
+            }
+            int in_sel = 0;
+
+            int len = buf->row[filerow].rsize - w->coloff;
+            if(len < 0) len = 0;
+            if(len > w->cols) len = w->cols; // truncate the line if it's necessary
+            width = len;
+
+            // color red digits
+            char *c = &buf->row[filerow].render[w->coloff];
+            unsigned char *hl = &buf->row[filerow].highlight[w->coloff]; // to the slice of the hightligh array that corresponds to the slice of render that we are printing
+            int current_color = -1; // track current char to minimize printing scape sequences
+            int j;
+            for(j = 0; j < len; j++) {
+                if((j >= sel_from && j < sel_to) != in_sel) {
+                    in_sel = !in_sel;
+                    abAppend(ab, in_sel ? "\x1b[7m" : "\x1b[27m", in_sel ? 4 : 5);
+                }
+                if(iscntrl(c[j])) { // check if the current character is a control character
+                    char sym = (c[j] <= 26) ? '@' + c[j] : '?'; // try to convert it to printable character
+                    // inside the block selection the colors are inverted already, and stay so for the rest of it
+                    if(!in_sel) abAppend(ab, "\x1b[7m", 4); // invert colors
+                    abAppend(ab, &sym, 1);
+                    if(!in_sel) abAppend(ab, "\x1b[m", 3); // restore colors
+
+                    // since <esc>[m turns off all text formatting, including colors. So let’s print the escape sequence for the current color afterwards.
+                    if(!in_sel && current_color != -1) {
+                        char buf[16];
+                        int clen = snprintf(buf, sizeof(buf), "\x1b[%dm", current_color);
+                        abAppend(ab, buf, clen);
+                    }
+                }
+                else {
+                    if(hl[j] == HL_NORMAL || E.lowbw) { // no colors on a slow link
+                        if(current_color != -1) {
+                            abAppend(ab, "\x1b[39m", 5);
+                            current_color = -1;
+                        }
+                    }
+                    else {
+                        int color = editorSyntaxToColor(hl[j]);
+                        if(color != current_color) {
+                            current_color = color;
+                            char buf[16];
+                            int color_len = snprintf(buf, sizeof(buf), "\x1b[%dm", color); // write the escape sequence into a buffer
+                            abAppend(ab, buf, color_len);
+                        }
+                    }
+                    // the actual characters: a run of the same one, in the same color and on the same side of the selection
+                    int run = 1;
+                    while(j + run < len && c[j + run] == c[j] && (hl[j + run] == hl[j] || E.lowbw)
+                        && ((j + run >= sel_from && j + run < sel_to) == in_sel)) run++;
+                    editorAppendRun(ab, c[j], run, !in_sel);
+                    j += run - 1;
+                }
+            }
+            if(in_sel) abAppend(ab, "\x1b[27m", 5);
+            abAppend(ab, "\x1b[39m", 5); // reset to default text color
+        }
+        /* The K command (Erase In Line) erases part of the current line. 
+        Its argument is analogous to the J command’s argument: 2 erases the whole line, 
+        1 erases the part of the line to the left of the cursor, 
+        and 0 erases the part of the line to the right of the cursor (default)
+        */
+        if(w->left + w->cols == E.textcols) {
+            abAppend(ab, "\x1b[K", 3); // clear each line as we redraw it
+        }
+        else {
+            if(width < w->cols) editorAppendRun(ab, ' ', w->cols - width, 1);
+            abAppend(ab, "\x1b[7m|\x1b[27m", 10); // the separator with the window on the right
+        }
+        // and for all except the last line, print \r\n
+        // if(y < E.screenrows - 1) {
+        //     abAppend(ab, "\r\n", 2);
+        // }
+
+        if(stream) abAppend(ab, "\r\n", 2);
+    }
+}
+
+/*** parallel composition ***/
+/* On a big terminal (a 4K monitor in full screen is about 400x120 cells) building the rows is most of the frame.
+From E.compose_cells cells in a window on, and with two workers or more in the pool, editorComposeRows() splits the rows in slices of
+EDITOR_COMPOSE_ROWS, which the workers and the main thread draw at the same time with poolFor(), each into its
+own abuf. Then they are appended in order, which gives the same bytes as drawing them one after the other.
+Smaller terminals are drawn serially: there, handing out the slices costs more than it saves. */
+#define EDITOR_COMPOSE_CELLS 20000
+#define EDITOR_COMPOSE_ROWS 8
+
+struct editorCompose {
+    struct editorWindow *w;
+    int first, last; // the rows of w to draw
+    struct editorBlockRect *block; // worked out before, the workers mustn't touch frozen rows
+    struct abuf *slices;
+};
+
+void editorComposeSlice(void *ctx, int i) {
+    // on a worker: it only reads E and the rows, warmed beforehand, which don't change until all the slices are done
+    struct editorCompose *compose = ctx;
+    int first = compose->first + i * EDITOR_COMPOSE_ROWS;
+    int last = first + EDITOR_COMPOSE_ROWS - 1;
+    if(last > compose->last) last = compose->last;
+    editorDrawRows(&compose->slices[i], compose->w, first, last, compose->block);
+}
+
+void editorComposeRows(struct abuf *ab, struct editorWindow *w, int first, int last) {
+    int rows = last - first + 1;
+    struct editorBlockRect rect, *block = editorWindowBlock(w, &rect);
+    if(!E.compose_cells || rows * w->cols < E.compose_cells || poolThreads() < 2) {
+        editorDrawRows(ab, w, first, last, block);
+        return;
+    }
+
+    int n = (rows + EDITOR_COMPOSE_ROWS - 1) / EDITOR_COMPOSE_ROWS;
+    struct editorCompose compose = { w, first, last, block, yateMalloc(n * sizeof(struct abuf)) };
+    if(!compose.slices) {
+        editorDrawRows(ab, w, first, last, block);
+        return;
+    }
+    for(int i = 0; i < n; i++) compose.slices[i] = (struct abuf) ABUF_INIT;
+    poolFor(editorComposeSlice, &compose, n);
+    for(int i = 0; i < n; i++) {
+        abAppend(ab, compose.slices[i].b, compose.slices[i].len);
+        abFree(&compose.slices[i]);
+    }
+    yateFree(compose.slices);
+}
+
+
+/*** windows ***/
+/* The screen above the bars can be split in windows: Ctrl-W then s splits the active one in a top and a bottom
+half, v in a left and a right half, w (or Ctrl-W again) goes to the next one, c closes the active one and o
+closes all the others. Every window has its own cursor and scroll, but windows on the same file show the same
+struct editorBuffer: a row is rendered and highlighted once whatever the number of windows that show it, and an
+edit made in one is in all of them. E.cx, E.cy, E.rowoff, E.coloff, E.screenrows and E.screencols are those of
+the active window, so the rest of the editor doesn't know about windows; the others keep theirs in E.windows.
+
+A frame only redraws the active window and the windows whose region changed. The others are subscribed to the
+changes of their buffer (see editorSubscribe()), and are redrawn when a change reaches the rows they show, which
+also moves their cursor along with the lines inserted or deleted above it. The active window is subscribed too,
+but only to drop what it collects, its own edits, so that it doesn't follow them a second time once it's left
+(see editorWindowsFollow()). With more than one window, each ends
+with a status line, and the ones that don't reach the right edge of the screen with a separator column. */
+
+void editorDamageAll() {
+    // the next frame draws every window again, after a resize or a change of layout
+    for(int i = 0; i < E.nwindows; i++) E.windows[i].drawn = 0;
+}
+
+void editorFrameDropped() {
+    /* The front end dropped a frame that never went out (see editorIO). The windows it drew aren't drawn again
+    by the frames after it unless they change, so they all are, as soon as the terminal keeps up. */
+    editorDamageAll();
+    E.stale = 1;
+}
+
+void editorWindowLayout(struct editorWindow *w) {
+    w->rows = w->height - (E.nwindows > 1); // its status line
+    w->cols = w->width - (w->left + w->width < E.textcols); // its separator
+    if(w->rows < 1) w->rows = 1;
+    if(w->cols < 1) w->cols = 1;
+}
+
+void editorWindowSave() {
+    // keep the state of the active window, before another one becomes active or the windows are drawn
+    struct editorWindow *w = &E.windows[E.window];
+    w->file = E.file;
+    w->cx = E.cx;
+    w->cy = E.cy;
+    w->rx = E.rx;
+    w->rowoff = E.rowoff;
+    w->coloff = E.coloff;
+}
+
+void editorWindowLoad(int i) {
+    struct editorWindow *w = &E.windows[i];
+    E.window = i;
+    E.file = w->file;
+    E.buf = E.files[w->file].buf;
+    E.cx = w->cx;
+    E.cy = w->cy;
+    E.rx = w->rx;
+    E.rowoff = w->rowoff;
+    E.coloff = w->coloff;
+    E.screenrows = w->rows;
+    E.screencols = w->cols;
+}
+
+int editorWindowFollow(struct editorWindow *w) {
+    /* For a window that isn't the active one: catch up with the changes of its buffer. Its cursor moves with the
+    lines inserted or deleted above it. Returns 1 when it has to be drawn again. */
+    struct editorChanges c;
+    struct editorBuffer *buf = E.files[w->file].buf;
+    if(!editorConsumeChanges(buf, w->sub, &c)) return 0;
+    int cy = w->cy;
+    if(c.shift != 0) {
+        int old_last = c.last - c.shift; // where the end of the change was before it
+        if(w->cy > old_last) w->cy += c.shift;
+        else if(w->cy > c.last) w->cy = c.last; // its line was deleted
+        if(w->rowoff > old_last) w->rowoff += c.shift;
+        else if(w->rowoff > c.last) w->rowoff = c.last;
+    }
+    if(w->cy > buf->numrows) w->cy = buf->numrows;
+    if(w->cy < 0) w->cy = 0;
+    if(w->rowoff > w->cy) w->rowoff = w->cy;
+    if(w->rowoff < 0) w->rowoff = 0;
+    int size = w->cy < buf->numrows ? buf->row[w->cy].size : 0;
+    if(w->cx > size) w->cx = size;
+    w->rx = w->cy < buf->numrows ? editorRowCxToRx(&buf->row[w->cy], w->cx) : 0;
+    return cy != w->cy || c.first <= w->rowoff + w->rows - 1;
+}
+
+void editorWindowsFollow() {
+    /* Keep the state of the active window, and bring the others up to date with their buffer. What the active
+    window collected are its own edits, which are already where its cursor is: they are dropped, not followed. */
+    struct editorChanges c;
+    editorWindowSave();
+    for(int i = 0; i < E.nwindows; i++) {
+        struct editorWindow *w = &E.windows[i];
+        if(i == E.window) editorConsumeChanges(E.files[w->file].buf, w->sub, &c);
+        else if(editorWindowFollow(w)) w->drawn = 0;
+    }
+}
+
+void editorWindowsSubscribe() {
+    /* With a single window there is nothing to follow, and its buffer doesn't need to record its changes. */
+    for(int i = 0; i < E.nwindows; i++) {
+        struct editorWindow *w = &E.windows[i];
+        editorUnsubscribe(E.files[w->file].buf, w->sub);
+        w->sub = E.nwindows > 1 ? editorSubscribe(E.files[w->file].buf) : -1;
+    }
+}
+
+void editorWindowsChanged() {
+    // after a change of layout: new sizes, new subscriptions, and everything drawn again
+    for(int i = 0; i < E.nwindows; i++) editorWindowLayout(&E.windows[i]);
+    editorWindowsSubscribe();
+    editorDamageAll();
+    E.block = 0;
+    editorWindowLoad(E.window);
+}
+
+int editorFileShown(int file) {
+    for(int i = 0; i < E.nwindows; i++) if(E.windows[i].file == file) return 1;
+    return 0;
+}
+
+void editorWindowSplit(int vertical) {
+    editorWindowsFollow();
+    struct editorWindow *w = &E.windows[E.window];
+    if(E.nwindows == EDITOR_WINDOWS || (vertical ? w->width < 8 : w->height < 4)) {
+        editorSetStatusMessage("No room for another window");
+        return;
+    }
+    struct editorWindow *n = &E.windows[E.nwindows];
+    *n = *w;
+    n->sub = -1;
+    if(vertical) {
+        w->width = w->width / 2;
+        n->left = w->left + w->width;
+        n->width -= w->width;
+    }
+    else {
+        w->height = w->height / 2;
+        n->top = w->top + w->height;
+        n->height -= w->height;
+    }
+    E.window = E.nwindows++;
+    editorWindowsChanged();
+}
+
+int editorWindowAbuts(struct editorWindow *w, struct editorWindow *o, int side) {
+    /* 1 when o touches side (0 above, 1 below, 2 left, 3 right) of w, within the span of that side of w */
+    switch(side) {
+        case 0: return o->top + o->height == w->top && o->left >= w->left && o->left + o->width <= w->left + w->width;
+        case 1: return o->top == w->top + w->height && o->left >= w->left && o->left + o->width <= w->left + w->width;
+        case 2: return o->left + o->width == w->left && o->top >= w->top && o->top + o->height <= w->top + w->height;
+        default: return o->left == w->left + w->width && o->top >= w->top && o->top + o->height <= w->top + w->height;
+    }
+}
+
+void editorWindowClose() {
+    /* Give the region of the active window to the windows on one of its sides, which together span all of it:
+    since every layout comes from splitting windows in two, one of the sides always works. */
+    if(E.nwindows == 1) {
+        editorSetStatusMessage("It's the only window");
+        return;
+    }
+    editorWindowsFollow();
+    struct editorWindow *w = &E.windows[E.window];
+    for(int side = 0; side < 4; side++) {
+        int covered = 0, first = -1;
+        for(int i = 0; i < E.nwindows; i++) {
+            struct editorWindow *o = &E.windows[i];
+            if(o == w || !editorWindowAbuts(w, o, side)) continue;
+            covered += side < 2 ? o->width : o->height;
+            if(first == -1) first = i;
+        }
+        if(covered != (side < 2 ? w->width : w->height)) continue;
+
+        for(int i = 0; i < E.nwindows; i++) {
+            struct editorWindow *o = &E.windows[i];
+            if(o == w || !editorWindowAbuts(w, o, side)) continue;
+            if(side == 0) o->height += w->height;
+            if(side == 1) { o->top = w->top; o->height += w->height; }
+            if(side == 2) o->width += w->width;
+            if(side == 3) { o->left = w->left; o->width += w->width; }
+        }
+        editorUnsubscribe(E.files[w->file].buf, w->sub);
+        int closed = E.window;
+        memmove(w, w + 1, (E.nwindows - closed - 1) * sizeof(struct editorWindow));
+        E.nwindows--;
+        E.window = first > closed ? first - 1 : first;
+        editorWindowsChanged();
+        return;
+    }
+}
+
+void editorWindowOnly() {
+    editorWindowsFollow();
+    for(int i = 0; i < E.nwindows; i++) {
+        if(i != E.window) editorUnsubscribe(E.files[E.windows[i].file].buf, E.windows[i].sub);
+    }
+    E.windows[0] = E.windows[E.window];
+    struct editorWindow *w = &E.windows[0];
+    w->top = w->left = 0;
+    w->height = E.textrows;
+    w->width = E.textcols;
+    E.nwindows = 1;
+    E.window = 0;
+    editorWindowsChanged();
+}
+
+void editorWindowNext() {
+    if(E.nwindows == 1) return;
+    editorWindowsFollow(); // the one about to be left stops at its own edits, the next one catches up with them
+    editorStopBackground(); // it follows the buffer of the active window
+    E.block = 0;
+    E.windows[E.window].drawn = 0; // its status line changes
+    editorWindowLoad((E.window + 1) % E.nwindows);
+    E.windows[E.window].drawn = 0;
+    E.files[E.file].shown = ++E.files_clock;
+    editorHighlightInBackground();
+}
+
+void editorWindowCommand(int c) {
+    // the key after Ctrl-W
+    switch(c) {
+        case 's': editorWindowSplit(0); break;
+        case 'v': editorWindowSplit(1); break;
+        case 'w': case CTRL_KEY('w'): editorWindowNext(); break;
+        case 'c': editorWindowClose(); break;
+        case 'o': editorWindowOnly(); break;
+        default: editorSetStatusMessage("Ctrl-W then: s split, v vertical split, w next, c close, o only");
+    }
+}
+
+void editorWindowsResize(int rows, int cols) {
+    /* Scale every edge to the new size of the screen. An edge shared by two windows stays shared, since it
+    moves the same way for both; if a window becomes too small, only the active one is left. */
+    editorWindowsFollow();
+    int oldrows = E.textrows, oldcols = E.textcols;
+    E.textrows = rows;
+    E.textcols = cols;
+    int ok = oldrows > 0 && oldcols > 0; // otherwise there is nothing to scale from, the layout starts over
+    for(int i = 0; ok && i < E.nwindows; i++) {
+        struct editorWindow *w = &E.windows[i];
+        int bottom = (w->top + w->height) * rows / oldrows, right = (w->left + w->width) * cols / oldcols;
+        w->top = w->top * rows / oldrows;
+        w->left = w->left * cols / oldcols;
+        w->height = bottom - w->top;
+        w->width = right - w->left;
+        if(w->height < 1 + (E.nwindows > 1) || w->width < 2) ok = 0;
+    }
+    if(!ok || E.nwindows == 1) {
+        editorWindowOnly();
+        return;
+    }
+    editorWindowsChanged();
+}
+
+void editorWindowStatus(struct abuf *ab, struct editorWindow *w) {
+    // the status line under a window, in bold for the active one
+    struct editorBuffer *buf = E.files[w->file].buf;
+    char move[32], line[256];
+    abAppend(ab, move, snprintf(move, sizeof(move), "\x1b[%d;%dH", w->top + w->rows + 1, w->left + 1));
+    abAppend(ab, w == &E.windows[E.window] ? "\x1b[1;7m" : "\x1b[7m", w == &E.windows[E.window] ? 6 : 4);
+    int len = snprintf(line, sizeof(line), " %s%s %d/%d", buf->filename ? buf->filename : "[No Name]",
+        buf->dirty ? " +" : "", w->cy + 1, buf->numrows);
+    if(len > (int) sizeof(line) - 1) len = sizeof(line) - 1;
+    if(len > w->width) len = w->width;
+    abAppend(ab, line, len);
+    if(len < w->width) editorAppendRun(ab, ' ', w->width - len, 0);
+    abAppend(ab, "\x1b[m", 3);
+}
+
+void editorWindowDraw(struct abuf *ab, struct editorWindow *w) {
+    if(w->left == 0 && w->cols == E.textcols) { // the rows go on with \r\n, see editorDrawRows()
+        char move[32];
+        if(w->top == 0) abAppend(ab, "\x1b[H", 3);
+        else abAppend(ab, move, snprintf(move, sizeof(move), "\x1b[%d;1H", w->top + 1));
+    }
+    editorComposeRows(ab, w, 0, w->rows - 1);
+    if(E.nwindows > 1) editorWindowStatus(ab, w);
+    w->drawn = 1;
+    w->drawn_rowoff = w->rowoff;
+    w->drawn_coloff = w->coloff;
+}
+
+void editorDrawStatusBar(struct abuf *ab) {
+    /*To make the status bar stand out, we’re going to display it with inverted colors: 
+    black text on a white background. The escape sequence <esc>[7m switches to inverted colors, 
+    and <esc>[m switches back to normal formatting.
+
+    The m command (Select Graphic Rendition) causes the text printed after it to be printed 
+    with various possible attributes including normal (0), bold (1), underscore (4), blink (5), and inverted colors (7). 
+    For example, you could specify all of these attributes using the command <esc>[1;4;5;7m.
+    */
+    abAppend(ab, "\x1b[7m", 4);
+
+    char status[80], rstatus[80];
+    // display max 20 chars from filename
+    char which[32] = "";
+    if(E.nfiles > 1) snprintf(which, sizeof(which), "[%d/%d] ", E.file + 1, E.nfiles);
+    int len = snprintf(status, sizeof(status), "%s%.20s - %d lines %s", which,
+    E.buf->filename ? E.buf->filename : "[No Name]", E.buf->numrows,
+    E.buf->dirty ? "(modified)" : "");
+
+    // print the filetype and the actual row position in the file
+    char matches[32] = "";
+    if(E.search_matches >= 0) snprintf(matches, sizeof(matches), "%d matches | ", E.search_matches);
+    int rlen = snprintf(rstatus, sizeof(rstatus), "%s%s%s%s | %d/%d", matches, E.block ? "BLOCK | " : "",
+        E.lowbw ? "slow link | " : "",
+        E.buf->syntax ? E.buf->syntax->filetype : "no ft", E.cy + 1, E.buf->numrows);
+
+    if(len > E.textcols) len = E.textcols;
+    abAppend(ab, status, len);
+
+    while(len < E.textcols) {
+        if(E.textcols - len == rlen) {
+            abAppend(ab, rstatus, rlen);
+            break;
+        }
+        else {
+            abAppend(ab, " ", 1);
+            len++;
+        }
+    }
+    abAppend(ab, "\x1b[m", 3);
+    // Space for status message
+    abAppend(ab, "\r\n", 2);
+}
+
+void editorDrawPerf(struct abuf *ab) {
+    /* The performance HUD: last and p99 time of each step of a keystroke, in microseconds, then the size
+    of the last frame and how many rows the last key sent through the syntax highlighter. The times shown for
+    the write are the ones of the previous frame, since this one hasn't been written yet. */
+    struct perfRing *rings[] = { &E.perf.keypress, &E.perf.scroll, &E.perf.drawrows, &E.perf.write };
+    const char *names[] = { "key", "scr", "draw", "wr" };
+    char hud[160];
+    int len = 0;
+    for(int i = 0; i < 4; i++) {
+        len += snprintf(hud + len, sizeof(hud) - len, "%s %.1f/%.1f ", names[i],
+            perfLast(rings[i]) / 1000.0, perfPercentile(rings[i], 99) / 1000.0);
+    }
+    len += snprintf(hud + len, sizeof(hud) - len, "us | %d B/frame | %lld hl/key",
+        E.perf.frame_bytes, E.perf.rows_highlighted);
+    if(len > (int) sizeof(hud) - 1) len = sizeof(hud) - 1;
+    if(len > E.textcols) len = E.textcols;
+    abAppend(ab, hud, len);
+}
+
+void editorDrawMessageBar(struct abuf *ab) {
+    abAppend(ab, "\x1b[K", 3); // clear the message bar with the <esc>[K escape sequence
+    if(E.prompt.active) {
+        char line[256];
+        int len = snprintf(line, sizeof(line), E.prompt.prompt, E.prompt.buf);
+        if(len > (int) sizeof(line) - 1) len = sizeof(line) - 1;
+        if(len > E.textcols) len = E.textcols;
+        abAppend(ab, line, len);
+        return;
+    }
+    int msglen = strlen(E.statusmsg);
+    if(msglen > E.textcols) msglen = E.textcols;
+    // refresh only if the message is less than 5 seconds old
+    if(msglen && time(NULL) - E.statusmsg_time < 5) {
+        abAppend(ab, E.statusmsg, msglen);
+    }
+    else if(E.perf.visible) {
+        editorDrawPerf(ab);
+    }
+}
+
+
+void editorRefreshScreen() {
+    poolDrain(); // finish what the workers have done before drawing, see pool.h
+    E.frame_last = perfNow();
+    E.frame_due = 0;
+    traceBegin("editorRefreshScreen");
+    long long start = E.perf.visible ? perfNow() : 0;
+    traceBegin("editorScroll");
+    editorScroll();
+    traceEnd();
+    editorWindowsFollow();
+    for(int i = 0; i < E.nwindows; i++) {
+        struct editorWindow *w = &E.windows[i];
+        // what's about to be drawn, once the window caught up, can't wait for the idle task, nor stay cold (see the memory section)
+        struct editorBuffer *b = E.files[w->file].buf;
+        editorHighlightUpTo(b, w->rowoff + w->rows - 1);
+        for(int y = w->rowoff; y < w->rowoff + w->rows && y < b->numrows; y++) editorRowWarm(b, &b->row[y]);
+    }
+    editorReportDamaged(); // in time for the message bar of this frame, whatever read the lost rows
+    if(E.perf.visible) perfRecord(&E.perf.scroll, perfNow() - start);
+    /*The 4 in our write() call means we are writing 4 bytes out to the terminal. 
+    The first byte is \x1b, which is the escape character, or 27 in decimal.
+
+    We are writing an escape sequence to the terminal. Escape sequences always start with an escape character
+    followed by a [ character. Escape sequences instruct the terminal to do various text formatting tasks, 
+    such as coloring text, moving the cursor around, and clearing parts of the screen.
+
+    We are using the J command (Erase In Display) to clear the screen. Escape sequence commands take arguments,
+    which come before the command. In this case the argument is 2, which says to clear the entire screen. 
+    <esc>[1J would clear the screen up to where the cursor is, and <esc>[0J would clear the screen from the 
+    cursor up to the end of the screen.
+    */
+    // write(STDOUT_FILENO, "\x1b[2J", 4); // clear scren
+    // write(STDERR_FILENO, "\x1b[H", 3); // relocate cursor at top, the default args are row and column 1 and 1
+
+    struct abuf ab = ABUF_INIT;
+    abReserve(&ab, E.frame_peak); // frames of the same size don't grow it at all
+    // with synchronized output, the terminal shows nothing of the frame until all of it has arrived
+    if(E.sync_output) abAppend(&ab, "\x1b[?2026h", 8);
+    abAppend(&ab, "\x1b[?25l", 6); // hide cursor when repainting
+    // abAppend(&ab, "\x1b[2J", 4); // don't clear full screen, instead clear each line as we redraw it
+    if(E.perf.visible) start = perfNow();
+    traceBegin("editorDrawRows");
+    // while the terminal is behind, only the cursor row is sent, if the view didn't move (see editorOutputCheck())
+    struct editorWindow *active = &E.windows[E.window];
+    int partial = E.lowbw && E.backlog > 0 && active->drawn && E.rowoff == active->drawn_rowoff
+        && E.coloff == active->drawn_coloff;
+    char move[32];
+    if(partial) {
+        int y = E.cy - E.rowoff;
+        abAppend(&ab, move, snprintf(move, sizeof(move), "\x1b[%d;%dH", active->top + y + 1, active->left + 1));
+        struct editorBlockRect rect;
+        editorDrawRows(&ab, active, y, y, editorWindowBlock(active, &rect));
+    }
+    else {
+        // the windows that changed, see the windows section
+        for(int i = 0; i < E.nwindows; i++) {
+            if(i == E.window || !E.windows[i].drawn) editorWindowDraw(&ab, &E.windows[i]);
+        }
+    }
+    if(partial || E.nwindows > 1) abAppend(&ab, move, snprintf(move, sizeof(move), "\x1b[%d;1H", E.textrows + 1));
+    E.stale = partial;
+    for(int i = 0; i < E.nwindows; i++) E.stale |= !E.windows[i].drawn;
+    traceEnd();
+    if(E.perf.visible) perfRecord(&E.perf.drawrows, perfNow() - start);
+    editorDrawStatusBar(&ab);
+    editorDrawMessageBar(&ab);
+
+    // move the cursor to the position stored in E.cx and E.cy.
+    char buf[32];
+    // We changed the old H command into an H command with arguments, specifying the exact position 
+    // we want the cursor to move to. We add 1 to (E.cy - offset) and (E.cx - offet) to convert from 0-indexed values to the 1-indexed 
+    // values that the terminal uses.
+    snprintf(buf, sizeof(buf), "\x1b[%d;%dH", active->top + (E.cy - E.rowoff) + 1, active->left + (E.rx - E.coloff) + 1);
+    abAppend(&ab, buf, strlen(buf));
+
+    // write(STDOUT_FILENO, "\x1b[H", 3);
+    // abAppend(&ab, "\x1b[H", 4); // relocate cursor again
+    abAppend(&ab, "\x1b[?25h", 6); // show cursor again
+    if(E.sync_output) abAppend(&ab, "\x1b[?2026l", 8);
+
+    // write the full buffer
+    if(E.perf.visible) start = perfNow();
+    traceBegin("write");
+    E.io.write(ab.b, ab.len);
+    traceEndArg("bytes", ab.len);
+    if(ab.len > E.frame_peak) E.frame_peak = ab.len;
+    if(E.perf.visible) {
+        perfRecord(&E.perf.write, perfNow() - start);
+        E.perf.frame_bytes = ab.len;
+    }
+    abFree(&ab);
+    traceEnd();
+}
+
+void editorSetStatusMessage(const char *fmt, ...) {
+    /* The ... argument makes it a variadic function (it can take any number of arguments)
+    C’s way of dealing with these arguments is by having you call va_start() and va_end() on a value of type va_list. 
+    The last argument before the ... (in this case, fmt) must be passed to va_start(), 
+    so that the address of the next arguments is known. 
+
+    Then, between the va_start() and va_end() calls, you would call va_arg() and pass it the type of the next argument 
+    (which you usually get from the given format string) and it would return the value of that argument. 
+    In this case, we pass fmt and ap to vsnprintf() and it takes care of reading the format string and calling va_arg() 
+    to get each argument.
+    */
+    va_list ap;
+    va_start(ap, fmt);
+    // vsnprintf() helps us make our own printf()-style function. We store the resulting string in E.statusmsg
+    vsnprintf(E.statusmsg, sizeof(E.statusmsg), fmt, ap);
+    va_end(ap);
+    E.statusmsg_time = time(NULL); //  set E.statusmsg_time to the current time, which can be gotten by passing NULL to time()
+}
+
+/*** low bandwidth ***/
+/* Over a slow link (ssh across the world, a serial console), frames can pile up in the output queue faster than
+the terminal gets them, and then every key shows up late. The front end can tell how much is still queued
+(io.backlog, TIOCOUTQ on a tty). If some of what was written a frame or more ago still hasn't left, the terminal
+is behind, and until it has kept up for a second the frames are degraded:
+    - no syntax colors, which are a good part of the bytes of a frame,
+    - no frame at all while more than EDITOR_LOWBW_SKIP bytes are queued,
+    - only the cursor row and the bars while anything is queued; the full frame comes when the queue is empty.
+Ctrl-T (or YATE_LOWBW=on/off) forces the degraded mode on or off instead. */
+#define EDITOR_LOWBW_SKIP 4096
+#define EDITOR_LOWBW_RECOVER_NS 1000000000LL
+
+void editorOutputCheck() {
+    E.backlog = E.io.backlog ? E.io.backlog() : -1;
+    if(E.backlog < 0) E.backlog = 0;
+    if(E.lowbw_mode != LOWBW_AUTO) {
+        E.lowbw = E.lowbw_mode == LOWBW_ON;
+        return;
+    }
+    if(E.backlog > 0) {
+        E.lowbw = 1;
+        E.lowbw_clear = 0;
+        return;
+    }
+    if(!E.lowbw) return;
+    long long now = perfNow();
+    if(!E.lowbw_clear) E.lowbw_clear = now;
+    else if(now - E.lowbw_clear >= EDITOR_LOWBW_RECOVER_NS) E.lowbw = 0;
+}
+
+int editorOutputCaughtUp() {
+    /* While waiting for keys: 1 when a degraded screen can now be drawn in full. */
+    if(!E.lowbw && !E.stale) return 0;
+    int was = E.lowbw;
+    editorOutputCheck();
+    return E.backlog == 0 && (E.stale || was != E.lowbw);
+}
+
+void editorLowBandwidthToggle() {
+    const char *names[] = { "auto", "on", "off" };
+    E.lowbw_mode = (E.lowbw_mode + 1) % 3;
+    E.lowbw_clear = 0;
+    editorOutputCheck();
+    editorSetStatusMessage("Low-bandwidth mode: %s", names[E.lowbw_mode]);
+}
+
+
+/*** frame pacing ***/
+/* A frame per key is a waste when keys come faster than the terminal can show them: pasting, key repeat, a slow
+ssh link. The main loop calls editorFrame() instead of editorRefreshScreen(), which skips the frame while more
+input is waiting and keeps to at most 120 frames per second. The skipped frame isn't lost: editorReadKey() draws
+it as soon as the input stops and its time has come. While keys keep coming, there is still a frame every 100 ms
+so the user sees where it's going. */
+#define EDITOR_FRAME_NS (1000000000LL / 120)
+#define EDITOR_FRAME_STARVE_NS 100000000LL
+
+void editorFrame() {
+    long long since = perfNow() - E.frame_last;
+    int pending = E.io.pending && E.io.pending();
+    if((pending && since < EDITOR_FRAME_STARVE_NS) || since < EDITOR_FRAME_NS) {
+        E.frame_due = 1;
+        return;
+    }
+    editorOutputCheck();
+    if(E.lowbw && E.backlog > EDITOR_LOWBW_SKIP) { // the link is the bottleneck, another frame would only queue up
+        E.frame_due = 1;
+        return;
+    }
+    editorRefreshScreen();
+}
+
+void editorFrameWait() {
+    /* Draw the skipped frame once its time comes, unless a key comes first: that key's frame will show both. */
+    while(E.frame_due) {
+        if(E.io.pending && E.io.pending()) return;
+        long long wait = E.frame_last + EDITOR_FRAME_NS - perfNow();
+        if(wait <= 0) {
+            editorOutputCheck();
+            if(!E.lowbw || E.backlog <= EDITOR_LOWBW_SKIP) {
+                editorRefreshScreen();
+                return;
+            }
+            wait = 1000000;
+        }
+        struct timespec ts = { 0, wait < 1000000 ? wait : 1000000 }; // look at the input every ms
+        nanosleep(&ts, NULL);
+    }
+}
+
+
+/*** idle ***/
+/* Background work, run while the editor waits for a key (see idle.h). A task that changes what is on screen
+sets E.repaint, and the screen is refreshed between two slices. */
+void editorIdle() {
+    if(!E.io.pending) return;
+    while(idlePending() && !E.io.pending()) {
+        idleRun(IDLE_SLICE_NS);
+        if(E.repaint) {
+            E.repaint = 0;
+            editorRefreshScreen();
+        }
+    }
+}
+
+int editorHighlightTaskStep(void *ctx, long long deadline) {
+    return editorHighlightStep(ctx, deadline);
+}
+
+int highlight_task = 0; // id of the background highlighting, 0 when it isn't running
+
+void editorHighlightTaskDone(void *ctx, int cancelled) {
+    (void) ctx;
+    (void) cancelled;
+    highlight_task = 0;
+}
+
+void editorHighlightInBackground() {
+    /* Highlight the rows past the watermark of the buffer (see core.h) in idle time, after the search. */
+    if(highlight_task || E.buf->hl_done >= E.buf->numrows) return;
+    highlight_task = idleAdd("editorHighlightStep", 10, editorHighlightTaskStep, editorHighlightTaskDone, E.buf);
+}
+
+void editorStopBackground() {
+    /* The idle tasks work on E.buf: stop them before another buffer takes its place. */
+    idleCancel(highlight_task);
+    editorMatchCount(NULL);
+}
+
+void editorReportDamaged() {
+    /* Tell the user about the rows whose frozen text was lost (see editorChunkDamaged() in core.c): they show as
+    question marks now, and a save would write them so. */
+    for(int i = 0; i < E.nfiles; i++) {
+        struct editorBuffer *b = E.files[i].buf;
+        if(!b->damaged) continue;
+        editorSetStatusMessage("%d rows of %s were corrupted in memory, now ?: don't save over it", b->damaged,
+            b->filename ? b->filename : "[No Name]");
+        b->damaged = 0;
+    }
+}
+
+void editorReportInterrupt() {
+    /* After a long loop was stopped with Esc or Ctrl-C (see editorInterrupted() in core.c), tell how far it got.
+    An interrupted highlighting cascade left the rest of its rows behind the watermark, so restart the idle task. */
+    struct editorInterrupt *in = &E.buf->interrupt;
+    if(!in->interrupted) return;
+    in->interrupted = 0;
+    int percent = in->total > 0 ? (int) (in->done * 100 / in->total) : 0;
+    editorSetStatusMessage("%s interrupted after %lld of %lld %s (%d%%)", in->what, in->done, in->total, in->unit,
+        percent);
+    editorHighlightInBackground();
+}
+
+/*** buffers ***/
+/* `yate a.c b.c c.log` opens every file in its own buffer, and Ctrl-N shows the next one. A buffer is only
+read the first time it's shown, so a long list of files starts as fast as one. The buffers that aren't shown keep
+their render and highlight (see core.h), which are most of what they cost, until the heap grows past
+E.buffer_budget: then the ones shown the longest ago lose them first (editorBufferEvict()), and only their
+chars stay (see the memory budget section). The rows are rebuilt as they are drawn again. */
+#define EDITOR_BUFFER_BUDGET (256 * 1024 * 1024)
+
+int editorAddFile(const char *path) {
+    /* Add a buffer for path, to be opened when it's first shown. Returns its index. */
+    E.files = yateRealloc(E.files, sizeof(struct editorFile) * (E.nfiles + 1));
+    struct editorFile *f = &E.files[E.nfiles];
+    f->buf = yateMalloc(sizeof(struct editorBuffer));
+    editorBufferInit(f->buf);
+    f->buf->interrupt.check = E.io.interrupt; // see editorInterrupted() in core.c
+    f->buf->hl_lazy = 1; // draw the first screen as soon as possible, and highlight the rest when there is time
+    f->path = path ? yateStrdup(path) : NULL;
+    f->cx = f->cy = f->rowoff = f->coloff = 0;
+    f->shown = 0;
+    f->saving = f->save_again = 0;
+    return E.nfiles++;
+}
+
+size_t editorEvictBuffers(size_t need) {
+    /* Give back the render and highlight of hidden buffers, least recently shown first, until need bytes were
+    freed or only the buffers on screen are left. Returns how many bytes were. */
+    size_t freed = 0;
+    while(freed < need) {
+        int lru = -1;
+        for(int i = 0; i < E.nfiles; i++) {
+            struct editorFile *f = &E.files[i];
+            if(editorFileShown(i) || f->path || f->buf->evicted || f->buf->numrows == 0) continue;
+            if(lru == -1 || f->shown < E.files[lru].shown) lru = i;
+        }
+        if(lru == -1) break;
+        freed += editorBufferEvict(E.files[lru].buf);
+    }
+    return freed;
+}
+
+int editorShowFile(int i) {
+    /* Make files[i] the buffer of the active window, opening it if it's the first time. Returns -1 (with errno set) if the
+    file couldn't be opened, which leaves an empty buffer with that name, like a new file. */
+    if(i < 0 || i >= E.nfiles) return -1;
+    editorWindowsFollow(); // the subscriptions start over below
+    struct editorFile *f = &E.files[E.file];
+    f->cx = E.cx;
+    f->cy = E.cy;
+    f->rowoff = E.rowoff;
+    f->coloff = E.coloff;
+
+    // what was running on the old buffer stops here
+    editorStopBackground();
+    E.block = 0;
+
+    E.file = i;
+    f = &E.files[i];
+    f->shown = ++E.files_clock;
+    E.buf = f->buf;
+    E.cx = f->cx;
+    E.cy = f->cy;
+    E.rowoff = f->rowoff;
+    E.coloff = f->coloff;
+    editorWindowSave(); // the active window shows it now
+    editorWindowsSubscribe();
+    E.windows[E.window].drawn = 0;
+
+    int ret = 0;
+    if(f->path) {
+        char *path = f->path;
+        f->path = NULL;
+        if(editorOpen(f->buf, path) == -1) {
+            int err = errno;
+            if(err != EINTR) { // keep the name, saving creates it
+                yateFree(f->buf->filename);
+                f->buf->filename = path;
+                editorSelectSyntaxHighlight(f->buf);
+                path = NULL;
+            }
+            errno = err;
+            ret = -1;
+        }
+        yateFree(path);
+    }
+    editorHighlightInBackground();
+    editorMemoryCheck(1);
+    return ret;
+}
+
+int editorModifiedFiles() {
+    int n = 0;
+    for(int i = 0; i < E.nfiles; i++) n += E.files[i].buf->dirty != 0;
+    return n;
+}
+
+void editorNextFile() {
+    if(E.nfiles < 2) {
+        editorSetStatusMessage("No other buffer");
+        return;
+    }
+    int i = (E.file + 1) % E.nfiles;
+    if(editorShowFile(i) == -1 && errno != EINTR) {
+        editorSetStatusMessage("[%d/%d] %s: new file (%s)", i + 1, E.nfiles, E.buf->filename, strerror(errno));
+        return;
+    }
+    editorSetStatusMessage("[%d/%d] %s", i + 1, E.nfiles, E.buf->filename ? E.buf->filename : "[No Name]");
+    editorReportInterrupt(); // if opening it was interrupted
+}
+
+/*** memory budget ***/
+/* The render and highlight of a row are only derived from its chars (and from the rows above it, for the
+highlighting), so they can be freed when memory is short, and rebuilt when the row is drawn again (editorRowEvict()
+and editorRowWarm() in core.c). When the heap grows past E.buffer_budget, that's what is given back, from what is
+the farthest from the screen: the hidden buffers first, least recently shown first, then the rows
+of the buffers on screen that are the farthest from the windows that show them. The rows within a page of a
+window are always kept, so scrolling doesn't have to rebuild them. The budget is checked against the whole heap,
+which glibc keeps count of, so a check costs nothing until there is something to evict. Without glibc, it's checked
+against what the buffers hold, added up row by row.
+
+The front end can also tell when the whole system (or the cgroup of the editor) is short of memory, through
+io.pressure(). Then everything that can be rebuilt goes, whatever the budget, before the OOM killer comes.
+
+When that isn't enough, the text itself of the rows far from the windows is frozen: compressed a chunk of rows at a
+time, and decompressed again when it's read (editorBufferFreeze() in core.c). Compressing takes a while, so a check
+only does EDITOR_FREEZE_NS of it, and leaves the rest to the next ones, which come right after as long as there is
+no key to handle. */
+#define EDITOR_MEMORY_CHECK_NS 1000000000LL // how often the budget is checked, mallinfo2() walks the free lists
+#define EDITOR_FREEZE_NS 50000000LL // how long a check may spend compressing rows
+#define EDITOR_DISTANCES 33 // buckets of distances from the windows, by powers of 2, see editorEvictRows()
+
+int editorRowDistance(int file, int y) {
+    /* How many rows away from the closest window that shows files[file] row y is, past the page kept around
+    each window. 0 for the rows that are kept. */
+    int distance = -1;
+    for(int i = 0; i < E.nwindows; i++) {
+        struct editorWindow *w = &E.windows[i];
+        if(w->file != file) continue;
+        int d = 0;
+        if(y < w->rowoff - E.textrows) d = w->rowoff - E.textrows - y;
+        else if(y >= w->rowoff + w->rows + E.textrows) d = y - (w->rowoff + w->rows + E.textrows) + 1;
+        if(distance == -1 || d < distance) distance = d;
+    }
+    return distance;
+}
+
+int editorDistanceBucket(int distance) {
+    int bucket = 0;
+    for(; distance > 0; distance >>= 1) bucket++;
+    return bucket;
+}
+
+size_t editorEvictRows(size_t need) {
+    /* Make cold the rows of the buffers on screen, the farthest from the windows first, until need bytes were
+    freed or only the rows around the windows are left. Returns how many bytes were. The distances go in buckets
+    by powers of 2, so it's two passes over the rows whatever the need: one to add up what each bucket holds, and
+    one to evict the buckets from the farthest down to the one that covers the need. */
+    size_t held[EDITOR_DISTANCES] = { 0 };
+    for(int i = 0; i < E.nfiles; i++) {
+        struct editorBuffer *b = E.files[i].buf;
+        if(!editorFileShown(i)) continue;
+        for(int y = 0; y < b->numrows; y++) {
+            erow *row = &b->row[y];
+            if(!row->render) continue;
+            held[editorDistanceBucket(editorRowDistance(i, y))] += yateUsableSize(row->render, row->rsize + 1) +
+                yateUsableSize(row->highlight, row->rsize);
+        }
+    }
+    int from = EDITOR_DISTANCES;
+    size_t found = 0;
+    while(from > 1 && found < need) found += held[--from];
+    if(found == 0) return 0;
+
+    size_t freed = 0;
+    for(int i = 0; i < E.nfiles; i++) {
+        struct editorBuffer *b = E.files[i].buf;
+        if(!editorFileShown(i)) continue;
+        for(int y = 0; y < b->numrows; y++) {
+            erow *row = &b->row[y];
+            if(row->render && editorDistanceBucket(editorRowDistance(i, y)) >= from) freed += editorRowEvict(row);
+        }
+    }
+    return freed;
+}
+
+int editorRowBucket(int file, int y) {
+    // the bucket of distances of a row, the farthest one for the rows of hidden buffers
+    int distance = editorRowDistance(file, y);
+    return distance == -1 ? EDITOR_DISTANCES - 1 : editorDistanceBucket(distance);
+}
+
+size_t editorFreezeRows(size_t need) {
+    /* Freeze the rows of every buffer that was read, the farthest from the windows first, until need bytes were
+    freed or only the rows around the windows are left. Returns how many bytes were, and sets E.memory_behind if
+    it stopped after EDITOR_FREEZE_NS. Like editorEvictRows(), it adds up what the chars of each bucket of distances
+    hold first, then freezes the runs of rows in the buckets it needs, a few chunks at a time so it can stop
+    between them. */
+    size_t held[EDITOR_DISTANCES] = { 0 };
+    for(int i = 0; i < E.nfiles; i++) {
+        struct editorBuffer *b = E.files[i].buf;
+        if(E.files[i].path) continue;
+        for(int y = 0; y < b->numrows; y++) {
+            if(!b->row[y].chunk) held[editorRowBucket(i, y)] += yateUsableSize(b->row[y].chars, b->row[y].size + 1);
+        }
+    }
+    int from = EDITOR_DISTANCES;
+    size_t found = 0;
+    while(from > 1 && found < need) found += held[--from];
+    if(found == 0) return 0;
+
+    long long deadline = perfNow() + EDITOR_FREEZE_NS;
+    size_t freed = 0;
+    for(int i = 0; i < E.nfiles && freed < need; i++) {
+        struct editorBuffer *b = E.files[i].buf;
+        if(E.files[i].path) continue;
+        int y = 0;
+        while(1) {
+            while(y < b->numrows && (b->row[y].chunk || editorRowBucket(i, y) < from)) y++;
+            int start = y, raw = 0;
+            while(y < b->numrows && raw < 4 * EDITOR_CHUNK_BYTES && !b->row[y].chunk && editorRowBucket(i, y) >= from) {
+                raw += b->row[y++].size + 1;
+            }
+            if(start == y) break;
+            freed += editorBufferFreeze(b, start, y - 1);
+            if(perfNow() > deadline) {
+                E.memory_behind = 1;
+                return freed;
+            }
+        }
+    }
+    return freed;
+}
+
+size_t editorMemoryHeap() {
+    // adding up the rows takes a while on a big file, the allocator knows the total right away
+#ifdef __GLIBC__
+    struct mallinfo2 mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd; // in use, with the big blocks that got their own mmap()
+#else
+    size_t heap = 0;
+    for(int i = 0; i < E.nfiles; i++) {
+        if(E.files[i].path) continue; // not read yet
+        struct editorMemory m;
+        editorBufferMemory(E.files[i].buf, &m);
+        heap += m.rows + m.chars + m.render + m.highlight + m.frozen;
+    }
+    return heap;
+#endif
+}
+
+int editorMemoryCheck(int now) {
+    /* Keep the heap in E.buffer_budget, or give back all that can be rebuilt if the system is short of memory.
+    Called while waiting for keys, once in a while (or right now, with `now`, or as long as the last check was
+    behind). Returns 1 when it told the user, and the screen should be refreshed. */
+    int pressure = E.io.pressure && E.io.pressure();
+    int behind = E.memory_behind;
+    long long at = perfNow();
+    if(!pressure && !now && !behind && at - E.memory_checked < EDITOR_MEMORY_CHECK_NS) return 0;
+    E.memory_checked = at;
+    E.memory_behind = 0;
+    if(!pressure && !E.buffer_budget) return 0;
+
+    size_t heap = editorMemoryHeap();
+    size_t budget = pressure ? 0 : E.buffer_budget;
+    if(heap <= budget) E.memory_kept = 0;
+    if(heap <= budget + E.memory_kept) return 0;
+
+    // the distances are from where the windows are now: the other ones catch up with their buffer first
+    editorWindowsFollow();
+    // a check that only goes on with the freezing leaves the rest alone, the one before it gave that back already
+    int resume = behind && !pressure;
+    size_t freed = resume ? 0 : editorEvictBuffers(heap - budget);
+    if(!resume && freed < heap - budget) freed += editorEvictRows(heap - budget - freed);
+    if(freed < heap - budget) freed += editorFreezeRows(heap - budget - freed);
+#ifdef __GLIBC__
+    if(freed) malloc_trim(0); // free() keeps the memory in the process, this hands it back to the system
+#endif
+    // what couldn't be given back isn't looked for again until the heap grows past it
+    E.memory_kept = heap - freed > budget && !E.memory_behind ? heap - freed - budget : 0;
+    if(!pressure || !freed) return 0;
+
+    char f[16];
+    editorFormatBytes(f, sizeof(f), freed);
+    editorSetStatusMessage("Memory is short: gave back %s of render, highlight and text", f);
+    return 1;
+}
+
+/*** input ***/
+void editorPromptStart(const char *prompt, void (*callback)(char *, int), void (*done)(char *)) {
+    /* Ask the user for some input in the message bar. This returns right away: the main loop hands the next keys
+    to editorPromptKey(), which calls done() once the user presses Enter or Esc. */
+    struct editorPromptState *p = &E.prompt;
+    p->bufsize = 128;
+    p->buf = yateMalloc(p->bufsize); // The user’s input is stored in buf
+    p->buflen = 0;
+    p->buf[0] = '\0';
+    p->prompt = prompt;
+    p->callback = callback;
+    p->done = done;
+    p->active = 1;
+}
+
+void editorPromptFinish(int c, int accepted) {
+    // close the prompt before calling done(), so it can open another one
+    struct editorPromptState *p = &E.prompt;
+    char *buf = p->buf;
+    void (*callback)(char *, int) = p->callback;
+    void (*done)(char *) = p->done;
+    p->active = 0;
+    p->buf = NULL;
+
+    editorSetStatusMessage("");
+    if(callback) callback(buf, c);
+    if(accepted) {
+        if(done) done(buf);
+        else yateFree(buf);
+        return;
+    }
+    yateFree(buf);
+    if(done) done(NULL);
+}
+
+void editorPromptKey(int c) {
+    struct editorPromptState *p = &E.prompt;
+    if(c == DEL_KEY || c == CTRL_KEY('h') || c == BACKSPACE) {
+        if(p->buflen != 0) p->buf[--p->buflen] = '\0';
+    }
+    // user can cancel the operation pressing the scape key
+    else if(c == '\x1b') { // in Bash on Windows, you must press 3 times
+        editorPromptFinish(c, 0);
+        return;
+    }
+    else if(c == '\r') { // enter key
+        // When the user presses Enter, and their input is not empty, the status message is cleared and their input is handed to done()
+        if(p->buflen != 0) {
+            editorPromptFinish(c, 1);
+            return;
+        }
+    }
+    // when they input a printable character, we append it to buf. If buflen has reached the maximum capacity 
+    // we allocated (stored in bufsize), then we double bufsize and allocate that amount of memory before 
+    // appending to buf.
+    else if(!iscntrl(c) && c < 128) { // make sure the input key isn’t one of the special keys in the editorKey enum, which have high integer value
+        if(p->buflen == p->bufsize - 1) {
+            p->bufsize *= 2;
+            p->buf = yateRealloc(p->buf, p->bufsize);
+        }
+        p->buf[p->buflen++] = c;
+        p->buf[p->buflen] = '\0';
+    }
+
+    if(p->callback) p->callback(p->buf, c);
+}
+
+
+void editorMoveCursor(int key) {
+    erow *row = (E.cy >= E.buf->numrows) ? NULL : &E.buf->row[E.cy];
+
+    switch (key) {
+        case ARROW_LEFT:
+            if(E.cx != 0) {
+                E.cx--;
+            }
+            else if(E.cy > 0) {
+                E.cy--;
+                E.cx = E.buf->row[E.cy].size;
+            }
+            break;
+        case ARROW_RIGHT:
+            if(row && E.cx < row->size) {
+                E.cx++;
+            }
+            else if(row && E.cx == row->size) {
+                E.cy++;
+                E.cx = 0;
+            }
+            break;
+        case ARROW_UP:
+            if(E.cy != 0) {
+                E.cy--;
+            }
+            break;
+        case ARROW_DOWN:
+            if(E.cy < E.buf->numrows) {
+                E.cy++;
+            }
+            break;
+    }
+
+    row = (E.cy >= E.buf->numrows) ? NULL : &E.buf->row[E.cy];
+    int rowlen = row ? row->size : 0;
+    if(E.cx > rowlen) {
+        E.cx = rowlen;
+    }
+}
+
+
+void editorProcessKey(int c) {
+    static int quit_times = KILO_QUIT_TIMES;
+
+    if(E.prompt.active) {
+        editorPromptKey(c);
+        return;
+    }
+
+    if(E.window_prefix) {
+        E.window_prefix = 0;
+        editorWindowCommand(c);
+        return;
+    }
+
+    if(E.block) {
+        // while a block selection is active, editing keys apply to the whole block
+        switch (c) {
+            case BACKSPACE:
+            case CTRL_KEY('h'):
+            case DEL_KEY:
+                editorBlockDelete(c);
+                return;
+            case CTRL_KEY('y'):
+                editorBlockYank();
+                return;
+            case CTRL_KEY('x'):
+                editorBlockCut();
+                return;
+            case '\r':
+            case '\x1b':
+                editorBlockToggle(); // the selection is confirmed or dropped, the line stays as it is
+                return;
+            default:
+                if(!iscntrl(c) && c < 128) {
+                    editorBlockInsertChar(c);
+                    return;
+                }
+        }
+    }
+
+    switch (c) {
+        case '\r': // enter key
+            editorInsertNewLine();
+            break;
+        case CTRL_KEY('q'):
+            // quit confirmation
+            if(editorModifiedFiles() && quit_times > 0) {
+                editorSetStatusMessage("WARNING!!! %d file(s) have unsaved changes. "
+                    "Press Ctrl-Q %d more times to quit.", editorModifiedFiles(), quit_times
+                );
+                quit_times--;
+                return;
+            }
+            poolWait(); // don't leave a save half written
+            // reset screen
+            E.io.write("\x1b[2J\x1b[H", 7); // clear scren and relocate cursor position, in one frame
+            exit(0);
+            break;
+        case CTRL_KEY('s'):
+            editorSave();
+            break;
+        case HOME_KEY:
+            E.cx = 0;
+            break;
+        case END_KEY:
+            if(E.cy < E.buf->numrows) {
+                E.cx = E.buf->row[E.cy].size;
+            }
+            break;
+        case CTRL_KEY('f'):
+            editorFind();
+            break;
+        case CTRL_KEY('b'):
+            editorBlockToggle();
+            break;
+        case CTRL_KEY('v'):
+            editorBlockPaste();
+            break;
+        case CTRL_KEY('p'):
+            E.perf.visible = !E.perf.visible;
+            E.statusmsg[0] = '\0'; // make room for the HUD right away
+            break;
+        case CTRL_KEY('g'):
+            editorMemorySummary();
+            break;
+        case CTRL_KEY('t'):
+            editorLowBandwidthToggle();
+            break;
+        case CTRL_KEY('n'):
+            editorNextFile();
+            break;
+        case CTRL_KEY('w'):
+            E.window_prefix = 1; // the next key says what to do, see editorWindowCommand()
+            break;
+        case BACKSPACE:
+        case CTRL_KEY('h'): // it sends the control code 8, which is originally what the Backspace character would send back in the day.
+        case DEL_KEY:
+            if (c == DEL_KEY) editorMoveCursor(ARROW_RIGHT);
+            editorDelChar();
+            break;
+        // If you’re on a laptop with an Fn key, you may be able to press Fn+↑ and Fn+↓ to simulate pressing 
+        // the Page Up and Page Down keys.
+        case PAGE_UP:
+        case PAGE_DOWN:
+            {      
+                if(c == PAGE_UP) {
+                    E.cy = E.rowoff;
+                }
+                else if(c == PAGE_DOWN) {
+                    E.cy = E.rowoff + E.screenrows - 1;
+                    if(E.cy > E.buf->numrows) E.cy = E.buf->numrows;
+                }
+
+                int times = E.screenrows;
+                while(times--) {
+                    editorMoveCursor(c == PAGE_UP ? ARROW_UP : ARROW_DOWN);
+                }
+            }
+            break;
+        case ARROW_UP:
+        case ARROW_DOWN:
+        case ARROW_LEFT:
+        case ARROW_RIGHT:
+            editorMoveCursor(c);
+            break;
+        case CTRL_KEY('l'): // Ctrl-L is traditionally used to refresh the screen in terminal programs
+        case '\x1b': // gnore the Escape key because there are many key escape sequences that we aren’t handling (such as the F1–F12 keys),
+            break;
+        default:
+            editorInsertChar(c);
+            break;
+    }
+
+    quit_times = KILO_QUIT_TIMES;
+}
+
+void editorProcessKeypress() {
+    /* waits for a keypress, and then handles it. The wait isn't part of the time the HUD shows for the key. */
+    int c = editorReadKey();
+    traceBegin("editorProcessKey");
+    if(!E.perf.visible) {
+        editorProcessKey(c);
+        editorReportInterrupt();
+        traceEndArg("key", c);
+        return;
+    }
+
+    long long start = perfNow();
+    long long highlighted = E.buf->highlighted;
+    editorProcessKey(c);
+    perfRecord(&E.perf.keypress, perfNow() - start);
+    E.perf.rows_highlighted = E.buf->highlighted - highlighted;
+    editorReportInterrupt();
+    traceEndArg("key", c);
+}
+
+
+void editorResize(int rows, int cols) {
+    /* The terminal changed size. Only the screen size, and the regions of the windows, depend on it: the scroll
+    offsets are fixed by editorScroll() on the next refresh, which redraws every window anyway. frame_peak was
+    the biggest frame of the old size. A terminal too small to show any text still gets a row and a column of
+    it, so that the windows can be scaled from them when it grows again. */
+    editorWindowsResize(rows - 2 < 1 ? 1 : rows - 2, cols < 1 ? 1 : cols);
+    E.frame_peak = 0;
+}
+
+
+/*** init ***/
+void editorFree() {
+    /* Give back what initEditor() and the session allocated: every file with its buffer, the block clipboard, an
+    open prompt and the highlighting kept from under a search match. The benchmarks call it after each run, so the
+    leak checkers only report the real leaks. */
+    poolWait(); // a save still running holds on to its buffer
+    editorBlockFreeClip();
+    if(E.prompt.active) yateFree(E.prompt.buf);
+    E.prompt.active = 0;
+    yateFree(saved_hl);
+    saved_hl = NULL;
+    editorMatchCount(NULL);
+    for(int i = 0; i < E.nfiles; i++) {
+        editorBufferFree(E.files[i].buf);
+        yateFree(E.files[i].buf);
+        yateFree(E.files[i].path);
+    }
+    yateFree(E.files);
+    E.files = NULL;
+    E.nfiles = 0;
+    E.buf = NULL;
+}
+
+void initEditor(struct editorIO io, int rows, int cols) {
+    E.cx = 0;
+    E.cy = 0;
+    E.rx = 0;
+    E.rowoff = 0; // We initialize it to 0, which means we’ll be scrolled to the top of the file by default.
+    E.coloff = 0; // same idea as the rowoff's initialization
+    E.io = io; // before the first buffer, which takes io.interrupt
+    // an empty buffer, with no filename and no syntax highlighting; the front end adds the files to open
+    E.files = NULL;
+    E.nfiles = 0;
+    E.file = editorAddFile(NULL);
+    E.files_clock = 0;
+    E.buffer_budget = EDITOR_BUFFER_BUDGET;
+    E.memory_checked = 0;
+    E.memory_kept = 0;
+    E.memory_behind = 0;
+    E.buf = E.files[E.file].buf;
+    E.buf->hl_lazy = 0;
+    E.statusmsg[0] = '\0'; // empty character
+    E.statusmsg_time = 0;
+    E.prompt.active = 0;
+    E.prompt.buf = NULL;
+    E.block = 0;
+    E.clip = NULL;
+    E.cliplen = NULL;
+    E.cliprows = 0;
+
+    memset(&E.perf, 0, sizeof(E.perf)); // the HUD starts hidden
+    E.frame_peak = 0;
+    E.repaint = 0;
+    E.search_matches = -1;
+    E.frame_last = 0;
+    E.frame_due = 0;
+    E.sync_output = 0;
+    E.term_rep = 0;
+    E.term_ech = 0;
+    E.lowbw_mode = LOWBW_AUTO;
+    E.compose_cells = EDITOR_COMPOSE_CELLS;
+    E.lowbw = 0;
+    E.backlog = 0;
+    E.lowbw_clear = 0;
+    E.stale = 0;
+    // don't draw nothing in the last two lines, reserve the last rows for the status bar and status message
+    E.textrows = rows - 2 < 1 ? 1 : rows - 2; // see editorResize()
+    E.textcols = cols < 1 ? 1 : cols;
+    // a single window, on the whole screen (see the windows section)
+    struct editorWindow *w = &E.windows[0];
+    memset(w, 0, sizeof(*w));
+    w->file = E.file;
+    w->height = E.textrows;
+    w->width = E.textcols;
+    w->sub = -1;
+    E.nwindows = 1;
+    E.window = 0;
+    E.window_prefix = 0;
+    editorWindowLayout(w);
+    editorWindowLoad(0);
+}
@@ -0,0 +1,200 @@
+#ifndef YATE_EDITOR_H
+#define YATE_EDITOR_H
+
+/*** editor ***/
+/* The interactive editor: cursor and scrolling, key handling, prompts and drawing the screen.
+
+It reads input bytes and writes frames through E.io instead of touching file descriptors, so it can
+run against a real terminal (yate.c puts the TTY in raw mode and plugs in stdin/stdout) or against
+an in-memory virtual terminal, like the replay benchmark in bench/ does.
+*/
+
+#include <stdio.h>
+#include <sys/types.h>
+#include <time.h>
+
+#include "core.h"
+#include "perf.h"
+
+/*** defines ***/
+
+#define YATE_VERSION "0.0.1"
+#define KILO_QUIT_TIMES 3
+
+/* The CTRL_KEY macro bitwise-ANDs a character with the value 00011111, in binary. 
+(In C, you generally specify bitmasks using hexadecimal, since C doesn’t have binary literals)
+
+It sets the upper 3 bits of the character to 0. This mirrors what the Ctrl key does in the terminal: 
+it strips bits 5 and 6 from whatever key you press in combination with Ctrl, and sends that.
+Example:
+    'q' = 113 in decimal, 1110001 in binary
+    113 & 31
+    01110001 & 
+    00011111
+=   00010001
+= 17 (which is the equivalent to Ctrl+q)
+*/
+#define CTRL_KEY(k) ((k) & 0x1f)
+
+/* By setting the first constant in the enum to 1000, the rest of the constants get incrementing values 
+of 1001, 1002, 1003, and so on. */
+enum editorKey {
+    BACKSPACE = 127, // ASCII value, since we can't represent it in C
+    ARROW_LEFT = 1000,
+    ARROW_RIGHT,
+    ARROW_UP,
+    ARROW_DOWN,
+    DEL_KEY, // the escape sequence: <esc>[3~
+    HOME_KEY, // The Home key could be sent as <esc>[1~, <esc>[7~, <esc>[H, or <esc>OH
+    END_KEY, // The End key could be sent as <esc>[4~, <esc>[8~, <esc>[F, or <esc>OF
+    PAGE_UP, // escape sequence: <esc>[5~
+    PAGE_DOWN // escape sequence: <esc>[6~
+};
+
+enum editorLowBandwidth { // E.lowbw_mode, cycled with Ctrl-T
+    LOWBW_AUTO = 0, // degrade the frames while the terminal falls behind
+    LOWBW_ON,
+    LOWBW_OFF
+};
+
+/*** data ***/
+
+struct editorIO {
+    /* Where the editor reads its input from and writes its output to. They behave like read() and write()
+    on the terminal: read() returns 1 when it got a byte, 0 if nothing arrived in time, and -1 on errors.
+    Every write() is a whole frame, which the front end may keep until the terminal can take it, and drop
+    when the next one comes before it started to go out, calling editorFrameDropped() then. */
+    ssize_t (*read)(void *buf, size_t count);
+    ssize_t (*write)(const void *buf, size_t count);
+    int (*pending)(); // 1 when input is waiting to be read; NULL if it can't tell, then idle tasks never run
+    int (*interrupt)(); // 1 when Esc or Ctrl-C is waiting, without taking the keys; NULL if long loops can't be stopped
+    int (*resized)(int *rows, int *cols); // 1 with the new size when the terminal was resized since the last call; may be NULL
+    int (*backlog)(); // bytes written but not taken by the terminal yet, -1 if unknown; may be NULL
+    int (*pressure)(); // 1 when the system ran short of memory since the last call, see editorMemoryCheck(); may be NULL
+};
+
+struct editorPerf {
+    /* What the performance HUD (Ctrl-P) shows. Nothing is measured while it is hidden. */
+    int visible;
+    struct perfRing keypress, scroll, drawrows, write; // nanoseconds spent in each, see perf.h
+    int frame_bytes; // size of the last frame written to the terminal
+    long long rows_highlighted; // rows that went through the syntax highlighter for the last key
+};
+
+struct editorPromptState {
+    /* While a prompt is open, the keys go to it instead of the buffer (see editorPromptStart()). It's just a mode
+    of the main loop, so idle tasks, background jobs and everything else keep going while the user types. */
+    int active; // flag
+    const char *prompt; // printf format with one %s, where the input goes
+    char *buf; // the input so far
+    size_t buflen, bufsize;
+    void (*callback)(char *input, int key); // after every key, e.g. for the incremental search; may be NULL
+    void (*done)(char *input); // Enter with the input, which it must free, or NULL when cancelled with Esc
+};
+
+struct editorFile {
+    /* One of the files given on the command line, see the buffers section of editor.c. Only the one shown is E.buf. */
+    struct editorBuffer *buf;
+    char *path; // the file to open the first time it's shown, NULL once it's loaded
+    int cx, cy, rowoff, coloff; // where the cursor was when another file was shown
+    unsigned long long shown; // E.files_clock when it was last shown, the least recent is evicted first
+    int saving; // flag, a save of its buffer is running on the worker pool, see editorSave()
+    int save_again; // flag, and it's saved again once that one is done, with the newer contents
+};
+
+#define EDITOR_WINDOWS 8
+
+struct editorWindow {
+    /* A view of one of the files in a region of the screen, see the windows section of editor.c. Any number of
+    them can show the same buffer, whose rows (render and highlight included) they all share. */
+    int file; // what it shows, an index in E.files
+    int cx, cy, rx, rowoff, coloff; // the cursor and scroll of the window; live in E while it's the active one
+    int top, left, height, width; // its region of the screen, with its status line and separator column
+    int rows, cols; // the part of the region where the text goes
+    int sub; // its subscription to the changes of the buffer (see editorSubscribe()), -1 without
+    int drawn; // flag, the screen shows the window as it is, unless its buffer changed since
+    int drawn_rowoff, drawn_coloff; // the scroll offsets it was last drawn with
+};
+
+struct editorConfig {
+    int cx, cy; // horizontal coordinate and vertical coordinate
+    int rx; // it'll be an index into the render field. If there are no tabs on the current line, then E.rx will be the same as E.cx. If there are tabs, then E.rx will be greater than E.cx
+    int rowoff; // keep track of what row of the file the user is currently scrolled to
+    int coloff; // keep track of what column of the file the user is currently scrolled to
+    int screenrows; // the size of the text of the active window
+    int screencols;
+    int textrows, textcols; // the size of the part of the screen the windows share, above the bars
+    struct editorWindow windows[EDITOR_WINDOWS];
+    int nwindows;
+    int window; // the active one, with the cursor
+    int window_prefix; // flag, Ctrl-W was pressed and the next key is a window command
+    struct editorBuffer *buf; // the text being edited, see core.h
+    struct editorFile *files; // every open file, E.buf is the one of files[file]
+    int nfiles;
+    int file;
+    unsigned long long files_clock; // bumped every time a file is shown
+    size_t buffer_budget; // bytes of heap the buffers may take before what can be rebuilt is given back, 0 no limit
+    long long memory_checked; // perfNow() time of the last editorMemoryCheck()
+    size_t memory_kept; // bytes over the budget that the last check couldn't give back, see editorMemoryCheck()
+    int memory_behind; // flag, the last check ran out of time before it got under the budget, the next one goes on
+    char statusmsg[80]; // messages to the user
+    time_t statusmsg_time;
+    struct editorPromptState prompt; // prompting the user for input when doing a search, for example
+    int block; // flag, a rectangular (block) selection is active
+    int block_cy, block_rx; // anchor of the block selection, in rows and render columns
+    char **clip; // rows yanked from the last block selection
+    int *cliplen;
+    int cliprows;
+    struct editorIO io;
+    struct editorPerf perf;
+    int frame_peak; // the biggest frame so far, editorRefreshScreen() reserves that much in its append buffer
+    int repaint; // flag, an idle task changed what is on screen
+    int search_matches; // matches of the current search query, counted by an idle task; -1 while unknown
+    long long frame_last; // perfNow() time of the last frame, see editorFrame()
+    int frame_due; // flag, a frame was skipped and the screen is behind
+    int sync_output; // flag, the terminal supports synchronized output (mode 2026), set by the front end
+    int term_rep, term_ech; // flags, the terminal understands REP and ECH, set by the front end (see editorAppendRun())
+    int compose_cells; // draw the rows in parallel from this many cells on, 0 never, see editorComposeRows()
+    int lowbw_mode; // enum editorLowBandwidth
+    int lowbw; // flag, frames are degraded right now, see editorOutputCheck()
+    int backlog; // what io.backlog() said at the last check
+    long long lowbw_clear; // perfNow() time since when the terminal has kept up, 0 while it doesn't
+    int stale; // flag, some rows were left out of the last frames
+};
+extern struct editorConfig E;
+
+/*** prototypes ***/
+void die(const char *s);
+int editorReadKey();
+int editorDecodeKey(char c);
+void editorSetStatusMessage(const char *fmt, ...);
+void editorRefreshScreen();
+void editorOutputCheck();
+int editorOutputCaughtUp();
+void editorFrame();
+void editorFrameWait();
+void editorPromptStart(const char *prompt, void (*callback)(char *, int), void (*done)(char *));
+void editorPromptKey(int c);
+void editorFindCallback(char *query, int key);
+void editorSave();
+void editorSaveFile(int i);
+void editorMemoryReport(FILE *fp);
+void editorIdle();
+void editorHighlightInBackground();
+void editorStopBackground();
+void editorReportInterrupt();
+void editorReportDamaged();
+void editorProcessKey(int c);
+void editorProcessKeypress();
+void editorResize(int rows, int cols);
+void editorDamageAll();
+void editorFrameDropped();
+int editorFileShown(int file);
+int editorAddFile(const char *path);
+int editorShowFile(int i);
+size_t editorMemoryHeap();
+int editorMemoryCheck(int now);
+void initEditor(struct editorIO io, int rows, int cols);
+void editorFree();
+
+#endif
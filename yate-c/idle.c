@@ -0,0 +1,84 @@
+/*** includes ***/
+
+#define _DEFAULT_SOURCE
+#define _BSD_SOURCE
+#define _GNU_SOURCE
+
+#include "idle.h"
+#include "perf.h"
+#include "trace.h"
+
+/*** data ***/
+struct idleTask {
+    int id; // 0 for a free slot
+    const char *name;
+    int priority;
+    long long turn; // when it last ran, for the turns among tasks of the same priority
+    idleStep step;
+    idleDone done;
+    void *ctx;
+};
+
+struct idleTask idle_tasks[IDLE_TASKS];
+int idle_next_id = 1;
+long long idle_turn = 0;
+
+/*** idle ***/
+int idleAdd(const char *name, int priority, idleStep step, idleDone done, void *ctx) {
+    /* Returns the id of the new task, for idleCancel(), or 0 if there are too many tasks already. */
+    for(int i = 0; i < IDLE_TASKS; i++) {
+        struct idleTask *t = &idle_tasks[i];
+        if(t->id) continue;
+        t->id = idle_next_id++;
+        t->name = name;
+        t->priority = priority;
+        t->turn = idle_turn++;
+        t->step = step;
+        t->done = done;
+        t->ctx = ctx;
+        return t->id;
+    }
+    return 0;
+}
+
+void idleFinish(struct idleTask *t, int cancelled) {
+    // free the slot first, so done() can add a new task
+    struct idleTask finished = *t;
+    t->id = 0;
+    if(finished.done) finished.done(finished.ctx, cancelled);
+}
+
+void idleCancel(int id) {
+    if(id == 0) return;
+    for(int i = 0; i < IDLE_TASKS; i++) {
+        if(idle_tasks[i].id == id) {
+            idleFinish(&idle_tasks[i], 1);
+            return;
+        }
+    }
+}
+
+int idlePending() {
+    for(int i = 0; i < IDLE_TASKS; i++) {
+        if(idle_tasks[i].id) return 1;
+    }
+    return 0;
+}
+
+int idleRun(long long slice) {
+    /* Give one slice to the most urgent task. Returns 0 when there was nothing to run. */
+    struct idleTask *next = NULL;
+    for(int i = 0; i < IDLE_TASKS; i++) {
+        struct idleTask *t = &idle_tasks[i];
+        if(!t->id) continue;
+        if(!next || t->priority < next->priority || (t->priority == next->priority && t->turn < next->turn)) next = t;
+    }
+    if(!next) return 0;
+
+    traceBegin(next->name);
+    next->turn = idle_turn++;
+    int more = next->step(next->ctx, perfNow() + slice);
+    traceEnd();
+    if(!more) idleFinish(next, 0);
+    return 1;
+}
@@ -0,0 +1,25 @@
+#ifndef YATE_IDLE_H
+#define YATE_IDLE_H
+
+/*** idle ***/
+/* A cooperative scheduler for the work the editor can do while it waits for the user, without threads.
+
+An idle task is a step function that does a bit of work and returns before a deadline: 1 while there is
+work left, 0 once it's finished. The editor calls idleRun() while no input is pending (see editorIdle()),
+so a task runs in slices of IDLE_SLICE_NS, and a key is handled at most one slice after it arrives.
+The task with the lowest priority number runs first, and tasks of the same priority run in turns.
+When a task finishes or is cancelled, its done() callback is called, which is where its context is freed.
+*/
+
+#define IDLE_TASKS 16
+#define IDLE_SLICE_NS 2000000LL // 2 ms
+
+typedef int (*idleStep)(void *ctx, long long deadline);
+typedef void (*idleDone)(void *ctx, int cancelled);
+
+int idleAdd(const char *name, int priority, idleStep step, idleDone done, void *ctx);
+void idleCancel(int id);
+int idlePending();
+int idleRun(long long slice);
+
+#endif
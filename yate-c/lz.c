@@ -0,0 +1,130 @@
+/*** includes ***/
+
+#define _DEFAULT_SOURCE
+#define _BSD_SOURCE
+#define _GNU_SOURCE
+
+#include <stdint.h>
+#include <string.h>
+
+#include "lz.h"
+
+/*** data ***/
+#define LZ_HASH_BITS 13 // 8192 positions, 32 KB on the stack
+
+/*** helpers ***/
+uint32_t lzRead32(const unsigned char *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v)); // compiles to a single load, without the alignment trouble of a cast
+    return v;
+}
+
+int lzHash(uint32_t seq) {
+    return (seq * 2654435761u) >> (32 - LZ_HASH_BITS); // Knuth's multiplicative hash, the top bits are the best
+}
+
+unsigned char *lzPutLength(unsigned char *out, int n) {
+    for(; n >= 255; n -= 255) *out++ = 255;
+    *out++ = n;
+    return out;
+}
+
+int lzGetLength(const unsigned char **in, const unsigned char *end, int *n) {
+    /* Add the extra length bytes at *in to *n. Returns -1 if the block ends in the middle of them. */
+    int byte;
+    do {
+        if(*in >= end) return -1;
+        byte = *(*in)++;
+        *n += byte;
+        if(*n < 0) return -1; // overflowed, not something lzCompress() wrote
+    } while(byte == 255);
+    return 0;
+}
+
+int lzEmit(unsigned char **out, unsigned char *end, const unsigned char *lit, int nlit, int offset, int mlen) {
+    /* Write one sequence: nlit literals, then a match of mlen bytes at offset, or no match when mlen is 0.
+    Returns 0 if it doesn't fit before end. */
+    unsigned char *o = *out;
+    if(end - o < 1 + nlit / 255 + 1 + nlit + 2 + mlen / 255 + 1) return 0;
+    unsigned char *token = o++;
+    if(nlit >= 15) o = lzPutLength(o, nlit - 15);
+    memcpy(o, lit, nlit);
+    o += nlit;
+    int ml = 0;
+    if(mlen) {
+        *o++ = offset & 0xff;
+        *o++ = offset >> 8;
+        ml = mlen - LZ_MIN_MATCH;
+        if(ml >= 15) o = lzPutLength(o, ml - 15);
+    }
+    *token = (nlit < 15 ? nlit : 15) << 4 | (ml < 15 ? ml : 15);
+    *out = o;
+    return 1;
+}
+
+/*** lz ***/
+int lzBound(int len) {
+    /* The biggest a block of len bytes can get, when nothing in it repeats. */
+    return len + len / 255 + 16;
+}
+
+int lzCompress(const char *src, int len, char *dst, int cap) {
+    /* Compress len bytes of src into dst. Returns the size of the block, or 0 if it didn't fit in cap bytes,
+    which is how a caller that only wants it if it's smaller finds out (cap = len). */
+    int table[1 << LZ_HASH_BITS]; // the last position where each hash of 4 bytes was seen
+    memset(table, 0xff, sizeof(table)); // -1, nothing seen yet
+    const unsigned char *in = (const unsigned char *) src;
+    unsigned char *out = (unsigned char *) dst, *end = out + cap;
+
+    int anchor = 0; // the first byte not written yet, the literals of the next sequence
+    int i = 0;
+    while(i <= len - LZ_MIN_MATCH) {
+        uint32_t seq = lzRead32(&in[i]);
+        int h = lzHash(seq);
+        int ref = table[h];
+        table[h] = i;
+        if(ref < 0 || i - ref > LZ_MAX_OFFSET || lzRead32(&in[ref]) != seq) {
+            i += 1 + ((i - anchor) >> 6); // the longer it goes without a match, the faster it skips ahead
+            continue;
+        }
+        int mlen = LZ_MIN_MATCH;
+        while(i + mlen < len && in[ref + mlen] == in[i + mlen]) mlen++;
+        if(!lzEmit(&out, end, &in[anchor], i - anchor, i - ref, mlen)) return 0;
+        i += mlen;
+        anchor = i;
+        if(i <= len - LZ_MIN_MATCH) table[lzHash(lzRead32(&in[i - 2]))] = i - 2; // so the next match can start in this one
+    }
+    if(!lzEmit(&out, end, &in[anchor], len - anchor, 0, 0)) return 0;
+    return out - (unsigned char *) dst;
+}
+
+int lzDecompress(const char *src, int len, char *dst, int cap) {
+    /* Decompress the block of len bytes at src into dst. Returns the size of what it got, or -1 if the block is
+    corrupt or doesn't fit in cap bytes: it never reads or writes past either buffer. */
+    const unsigned char *in = (const unsigned char *) src, *in_end = in + len;
+    unsigned char *out = (unsigned char *) dst, *out_end = out + cap;
+
+    while(in < in_end) {
+        int token = *in++;
+        int nlit = token >> 4;
+        if(nlit == 15 && lzGetLength(&in, in_end, &nlit) == -1) return -1;
+        if(nlit > in_end - in || nlit > out_end - out) return -1;
+        memcpy(out, in, nlit);
+        in += nlit;
+        out += nlit;
+        if(in == in_end) break; // the last sequence, without a match
+
+        if(in_end - in < 2) return -1;
+        int offset = in[0] | in[1] << 8;
+        in += 2;
+        int mlen = token & 15;
+        if(mlen == 15 && lzGetLength(&in, in_end, &mlen) == -1) return -1;
+        mlen += LZ_MIN_MATCH;
+        if(offset == 0 || offset > out - (unsigned char *) dst || mlen > out_end - out) return -1;
+        const unsigned char *ref = out - offset;
+        if(offset >= mlen) memcpy(out, ref, mlen);
+        else for(int k = 0; k < mlen; k++) out[k] = ref[k]; // overlaps what it writes: repeats the last offset bytes
+        out += mlen;
+    }
+    return out - (unsigned char *) dst;
+}
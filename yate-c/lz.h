@@ -0,0 +1,23 @@
+#ifndef YATE_LZ_H
+#define YATE_LZ_H
+
+/*** lz ***/
+/* A small LZ77 compressor in the spirit of LZ4, for the rows that are far from the screen (see the cold storage
+section of core.c). It goes for speed over ratio: one hash probe per position and greedy matches, which is plenty
+for logs and source code, where lines repeat most of the line above them.
+
+The compressed block is a sequence of sequences. Each one starts with a token byte: its high 4 bits are the number
+of literals and its low 4 bits the length of the match minus LZ_MIN_MATCH; 15 means that more length bytes follow,
+each one added until one is less than 255. Then come the extra bytes of the literal length, the literals, the
+offset of the match (2 bytes, little endian, 1 to LZ_MAX_OFFSET back in the output) and the extra bytes of the
+match length. The last sequence has only literals, and the block ends after them.
+*/
+
+#define LZ_MIN_MATCH 4
+#define LZ_MAX_OFFSET 65535
+
+int lzBound(int len);
+int lzCompress(const char *src, int len, char *dst, int cap);
+int lzDecompress(const char *src, int len, char *dst, int cap);
+
+#endif
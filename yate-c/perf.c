@@ -0,0 +1,98 @@
+/*** includes ***/
+
+#define _DEFAULT_SOURCE
+#define _BSD_SOURCE
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "perf.h"
+
+/*** perf ***/
+long long perfNow() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void perfRecord(struct perfRing *r, long long ns) {
+    r->ns[r->next] = ns;
+    r->next = (r->next + 1) % PERF_SAMPLES;
+    if(r->count < PERF_SAMPLES) r->count++;
+}
+
+long long perfLast(struct perfRing *r) {
+    if(r->count == 0) return 0;
+    return r->ns[(r->next + PERF_SAMPLES - 1) % PERF_SAMPLES];
+}
+
+int perfCompare(const void *a, const void *b) {
+    long long x = *(const long long *) a, y = *(const long long *) b;
+    return (x > y) - (x < y);
+}
+
+long long perfPercentile(struct perfRing *r, int p) {
+    /* The p-th percentile (0 to 100) of the samples in the ring, 0 when it's empty. */
+    if(r->count == 0) return 0;
+    long long sorted[PERF_SAMPLES];
+    memcpy(sorted, r->ns, r->count * sizeof(long long)); // until the ring wraps, the samples are at the start
+    qsort(sorted, r->count, sizeof(long long), perfCompare);
+    int i = (r->count * p + 99) / 100 - 1; // nearest rank
+    if(i < 0) i = 0;
+    return sorted[i];
+}
+
+void perfHistogramAdd(struct perfHistogram *h, long long ns) {
+    long long us = ns / 1000;
+    int i = 0;
+    while(us > 1 && i < PERF_BUCKETS - 1) {
+        us >>= 1;
+        i++;
+    }
+    h->buckets[i]++;
+    h->count++;
+    h->sum += ns;
+    if(ns > h->max) h->max = ns;
+}
+
+long long perfHistogramPercentile(struct perfHistogram *h, int p) {
+    /* The upper bound (in ns) of the bucket the p-th percentile falls in, so it is never under-reported. */
+    if(h->count == 0) return 0;
+    long long rank = (h->count * p + 99) / 100, seen = 0;
+    for(int i = 0; i < PERF_BUCKETS; i++) {
+        seen += h->buckets[i];
+        if(seen >= rank) {
+            long long bound = (2LL << i) * 1000;
+            return bound < h->max ? bound : h->max;
+        }
+    }
+    return h->max;
+}
+
+void perfHistogramPrint(struct perfHistogram *h, const char *title, FILE *fp) {
+    fprintf(fp, "%s: %lld samples", title, h->count);
+    if(h->count == 0) {
+        fprintf(fp, "\n");
+        return;
+    }
+    fprintf(fp, ", mean %.1f us, p50 <= %.1f us, p90 <= %.1f us, p99 <= %.1f us, max %.1f us\n",
+        h->sum / 1000.0 / h->count, perfHistogramPercentile(h, 50) / 1000.0, perfHistogramPercentile(h, 90) / 1000.0,
+        perfHistogramPercentile(h, 99) / 1000.0, h->max / 1000.0);
+
+    long long most = 0;
+    int first = -1, last = 0;
+    for(int i = 0; i < PERF_BUCKETS; i++) {
+        if(h->buckets[i] == 0) continue;
+        if(first == -1) first = i;
+        last = i;
+        if(h->buckets[i] > most) most = h->buckets[i];
+    }
+    for(int i = first; i <= last; i++) {
+        int bar = h->buckets[i] * 50 / most;
+        fprintf(fp, "  < %9lld us %8lld ", 2LL << i, h->buckets[i]);
+        for(int j = 0; j < bar; j++) fputc('#', fp);
+        fputc('\n', fp);
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef YATE_PERF_H
+#define YATE_PERF_H
+
+/*** perf ***/
+/* Cheap timing helpers for the performance HUD (Ctrl-P).
+
+A perfRing keeps the last PERF_SAMPLES durations of one operation in a ring buffer. Recording a sample
+is just a store, and the percentiles are only computed when the HUD is drawn, on a sorted copy.
+All durations are in nanoseconds, from the monotonic clock, so they don't jump when the wall clock is changed.
+*/
+
+#include <stdio.h>
+
+#define PERF_SAMPLES 256
+
+struct perfRing {
+    long long ns[PERF_SAMPLES];
+    int count; // number of valid samples, up to PERF_SAMPLES
+    int next; // where the next sample goes
+};
+
+#define PERF_BUCKETS 32
+
+struct perfHistogram {
+    /* A log2 histogram: bucket i counts the durations in [2^i, 2^(i+1)) microseconds, bucket 0 everything below 2 us. */
+    long long buckets[PERF_BUCKETS];
+    long long count;
+    long long sum, max; // nanoseconds
+};
+
+long long perfNow();
+void perfRecord(struct perfRing *r, long long ns);
+long long perfLast(struct perfRing *r);
+long long perfPercentile(struct perfRing *r, int p);
+void perfHistogramAdd(struct perfHistogram *h, long long ns);
+long long perfHistogramPercentile(struct perfHistogram *h, int p);
+void perfHistogramPrint(struct perfHistogram *h, const char *title, FILE *fp);
+
+#endif
@@ -0,0 +1,281 @@
+/*** includes ***/
+
+#define _DEFAULT_SOURCE
+#define _BSD_SOURCE
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "alloc.h"
+#include "pool.h"
+#include "trace.h"
+
+/*** data ***/
+#define POOL_MAX_THREADS 16
+
+struct poolDeque {
+    pthread_mutex_t lock;
+    struct poolJob *newest, *oldest; // the owner works at the newest end, thieves steal from the oldest end
+};
+
+struct poolWorker {
+    pthread_t thread;
+    int index;
+    struct poolDeque deque;
+};
+
+struct poolWorker pool_workers[POOL_MAX_THREADS];
+int pool_threads = 0; // 0 when the pool is not running
+int pool_next = 0; // the worker the next job from the main thread goes to
+
+pthread_mutex_t pool_sleep_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t pool_wakeup = PTHREAD_COND_INITIALIZER;
+int pool_queued = 0; // jobs waiting in the deques, guarded by pool_sleep_lock
+int pool_stopping = 0;
+
+struct poolJob *pool_completed = NULL; // lock-free stack of finished jobs, newest first
+int pool_busy = 0; // submitted and not drained yet, only used by the main thread
+
+/*** deques ***/
+void poolPush(struct poolDeque *d, struct poolJob *job) {
+    pthread_mutex_lock(&d->lock);
+    job->prev = NULL;
+    job->next = d->newest;
+    if(d->newest) d->newest->prev = job;
+    else d->oldest = job;
+    d->newest = job;
+    pthread_mutex_unlock(&d->lock);
+}
+
+struct poolJob *poolPop(struct poolDeque *d, int steal) {
+    pthread_mutex_lock(&d->lock);
+    struct poolJob *job = steal ? d->oldest : d->newest;
+    if(job) {
+        if(job->prev) job->prev->next = job->next;
+        else d->newest = job->next;
+        if(job->next) job->next->prev = job->prev;
+        else d->oldest = job->prev;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return job;
+}
+
+struct poolJob *poolTake(struct poolWorker *w) {
+    struct poolJob *job = poolPop(&w->deque, 0);
+    for(int i = 1; !job && i < pool_threads; i++) {
+        job = poolPop(&pool_workers[(w->index + i) % pool_threads].deque, 1);
+    }
+    return job;
+}
+
+/*** completion ***/
+void poolComplete(struct poolJob *job) {
+    // push onto the completion stack, a compare-and-swap loop instead of a lock
+    struct poolJob *head = __atomic_load_n(&pool_completed, __ATOMIC_RELAXED);
+    do {
+        job->next = head;
+    } while(!__atomic_compare_exchange_n(&pool_completed, &head, job, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+void poolRun(struct poolJob *job) {
+    void (*complete)(struct poolJob *job) = job->complete; // a job of poolFor() is freed by run()
+    if(!poolCancelled(job)) {
+        traceBegin("poolJob");
+        job->run(job);
+        traceEnd();
+    }
+    if(complete) poolComplete(job);
+}
+
+int poolHasCompleted() {
+    return __atomic_load_n(&pool_completed, __ATOMIC_ACQUIRE) != NULL;
+}
+
+int poolDrain() {
+    /* Call complete() for every finished job, oldest first, on the main thread. Returns how many there were. */
+    struct poolJob *list = __atomic_exchange_n(&pool_completed, NULL, __ATOMIC_ACQUIRE);
+    struct poolJob *ordered = NULL;
+    while(list) { // the stack is newest first, reverse it
+        struct poolJob *next = list->next;
+        list->next = ordered;
+        ordered = list;
+        list = next;
+    }
+
+    int n = 0;
+    while(ordered) {
+        struct poolJob *next = ordered->next;
+        ordered->complete(ordered);
+        pool_busy--;
+        n++;
+        ordered = next;
+    }
+    return n;
+}
+
+/*** workers ***/
+void *poolWorkerMain(void *arg) {
+    struct poolWorker *w = arg;
+    while(1) {
+        pthread_mutex_lock(&pool_sleep_lock);
+        while(pool_queued == 0 && !pool_stopping) pthread_cond_wait(&pool_wakeup, &pool_sleep_lock);
+        if(pool_queued == 0) { // stopping, and nothing left to do
+            pthread_mutex_unlock(&pool_sleep_lock);
+            return NULL;
+        }
+        pool_queued--; // one job is ours, somewhere in the deques
+        pthread_mutex_unlock(&pool_sleep_lock);
+
+        struct poolJob *job;
+        while(!(job = poolTake(w))) {} // it's there, another worker may just be moving past it
+        poolRun(job);
+    }
+}
+
+int poolStart(int threads) {
+    /* Start the workers, one per core when threads is 0. Returns how many were started. */
+    if(pool_threads) return pool_threads;
+    if(threads <= 0) threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if(threads > POOL_MAX_THREADS) threads = POOL_MAX_THREADS;
+    if(threads < 1) threads = 1;
+
+    pool_stopping = 0;
+    for(int i = 0; i < threads; i++) {
+        struct poolWorker *w = &pool_workers[i];
+        w->index = i;
+        pthread_mutex_init(&w->deque.lock, NULL);
+        w->deque.newest = w->deque.oldest = NULL;
+    }
+    pool_threads = threads; // the deques must all exist before the first worker looks at them
+    for(int i = 0; i < threads; i++) {
+        if(pthread_create(&pool_workers[i].thread, NULL, poolWorkerMain, &pool_workers[i]) != 0) {
+            pool_threads = i;
+            break;
+        }
+    }
+    return pool_threads;
+}
+
+void poolStop() {
+    /* Let the workers finish the queued jobs, and join them. Completed jobs still have to be drained. */
+    if(!pool_threads) return;
+    pthread_mutex_lock(&pool_sleep_lock);
+    pool_stopping = 1;
+    pthread_cond_broadcast(&pool_wakeup);
+    pthread_mutex_unlock(&pool_sleep_lock);
+    for(int i = 0; i < pool_threads; i++) pthread_join(pool_workers[i].thread, NULL);
+    pool_threads = 0;
+}
+
+/*** jobs ***/
+void poolEnqueue(struct poolJob *job) {
+    poolPush(&pool_workers[pool_next].deque, job);
+    pool_next = (pool_next + 1) % pool_threads;
+
+    pthread_mutex_lock(&pool_sleep_lock);
+    pool_queued++;
+    pthread_cond_signal(&pool_wakeup);
+    pthread_mutex_unlock(&pool_sleep_lock);
+}
+
+void poolSubmit(struct poolJob *job) {
+    pool_busy++;
+    if(!pool_threads) {
+        poolRun(job);
+        return;
+    }
+    poolEnqueue(job);
+}
+
+int poolThreads() {
+    return pool_threads;
+}
+
+void poolCancel(struct poolToken *token) {
+    if(token) __atomic_store_n(&token->cancelled, 1, __ATOMIC_RELAXED);
+}
+
+int poolCancelled(struct poolJob *job) {
+    return job->token && __atomic_load_n(&job->token->cancelled, __ATOMIC_RELAXED);
+}
+
+int poolBusy() {
+    return pool_busy;
+}
+
+void poolWait() {
+    /* Block until every submitted job has completed and been drained, for example before quitting. */
+    while(pool_busy) {
+        if(!poolDrain()) {
+            struct timespec ts = { 0, 1000000 }; // 1 ms
+            nanosleep(&ts, NULL);
+        }
+    }
+}
+
+/*** parallel loops ***/
+/* poolFor() is the other way to use the workers: a loop whose iterations run at the same time, and that
+returns when all of them are done. The caller takes iterations too, so it never waits for a worker that is busy
+with a long job (a save), it just does more of them itself. The helper jobs don't go through the completion
+queue: a helper that only starts after the loop is over finds no iteration left, and the last one to let go of
+the shared state frees it. */
+struct poolFor {
+    void (*fn)(void *ctx, int i);
+    void *ctx; // only touched through fn, while iterations are left, so it can live on the caller's stack
+    int n;
+    int next; // the next iteration to take
+    int done; // iterations finished
+    int refs; // the caller and the helpers that haven't let go yet
+    struct poolJob helpers[];
+};
+
+void poolForWork(struct poolFor *f) {
+    int i;
+    while((i = __atomic_fetch_add(&f->next, 1, __ATOMIC_ACQ_REL)) < f->n) {
+        f->fn(f->ctx, i);
+        __atomic_add_fetch(&f->done, 1, __ATOMIC_RELEASE);
+    }
+}
+
+void poolForRelease(struct poolFor *f) {
+    if(__atomic_sub_fetch(&f->refs, 1, __ATOMIC_ACQ_REL) == 0) yateFree(f);
+}
+
+void poolForRun(struct poolJob *job) {
+    struct poolFor *f = job->ctx;
+    poolForWork(f);
+    poolForRelease(f);
+}
+
+void poolFor(void (*fn)(void *ctx, int i), void *ctx, int n) {
+    /* Call fn(ctx, i) for every i in [0, n), on the workers and the caller. Without workers it's a plain loop. */
+    int helpers = pool_threads < n - 1 ? pool_threads : n - 1;
+    struct poolFor *f = helpers > 0 ? yateMalloc(sizeof(*f) + helpers * sizeof(struct poolJob)) : NULL;
+    if(!f) {
+        for(int i = 0; i < n; i++) fn(ctx, i);
+        return;
+    }
+    f->fn = fn;
+    f->ctx = ctx;
+    f->n = n;
+    f->next = 0;
+    f->done = 0;
+    f->refs = helpers + 1;
+    for(int i = 0; i < helpers; i++) {
+        struct poolJob *job = &f->helpers[i];
+        job->run = poolForRun;
+        job->complete = NULL;
+        job->token = NULL;
+        job->ctx = f;
+    }
+    __atomic_thread_fence(__ATOMIC_RELEASE); // all of it before any helper can see it
+    for(int i = 0; i < helpers; i++) poolEnqueue(&f->helpers[i]);
+
+    poolForWork(f);
+    while(__atomic_load_n(&f->done, __ATOMIC_ACQUIRE) < n) sched_yield(); // the last iterations, on the helpers
+    poolForRelease(f);
+}
@@ -0,0 +1,46 @@
+#ifndef YATE_POOL_H
+#define YATE_POOL_H
+
+/*** pool ***/
+/* A small work-stealing thread pool for the jobs that don't need to hold up the keyboard, like saving.
+
+The editor itself stays single-threaded: a job must only touch its own data, usually a snapshot taken on the
+main thread when it was submitted (never E or the rows of a buffer). Every worker has its own deque of jobs;
+it takes the newest job of its own deque, and when that's empty it steals the oldest job of another worker.
+A finished job is pushed, without locks, onto a completion queue that the main thread drains with poolDrain()
+before each editorRefreshScreen(). complete() runs there, on the main thread, so it can look at the buffer
+again, check that the snapshot is still current (see generation in core.h), and free the job.
+
+A job can be cancelled through its token; run() should check poolCancelled() now and then, and a job that
+was cancelled before it started is not run at all. complete() is called in every case.
+Without poolStart() (benchmarks, single-core machines) poolSubmit() runs the job right away on the caller.
+
+poolFor() runs the iterations of a loop on the workers and the caller at the same time, and returns when they
+are all done. Since the caller waits, they may read the editor's data, as long as they don't change it.
+*/
+
+struct poolToken {
+    int cancelled; // flag, set with poolCancel()
+};
+
+struct poolJob {
+    void (*run)(struct poolJob *job); // on a worker thread
+    void (*complete)(struct poolJob *job); // back on the main thread, from poolDrain(); it owns the job
+    struct poolToken *token; // NULL if the job can't be cancelled
+    void *ctx;
+    struct poolJob *next, *prev; // used by the pool
+};
+
+int poolStart(int threads);
+void poolStop();
+void poolSubmit(struct poolJob *job);
+void poolCancel(struct poolToken *token);
+int poolCancelled(struct poolJob *job);
+int poolHasCompleted();
+int poolDrain();
+int poolBusy();
+void poolWait();
+int poolThreads();
+void poolFor(void (*fn)(void *ctx, int i), void *ctx, int n);
+
+#endif
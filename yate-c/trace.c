@@ -0,0 +1,138 @@
+/*** includes ***/
+
+#define _DEFAULT_SOURCE
+#define _BSD_SOURCE
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "perf.h"
+#include "trace.h"
+
+/*** data ***/
+#define TRACE_EVENTS 4096 // per thread, before the buffer is flushed to the file
+#define TRACE_DEPTH 64 // deepest nesting of open spans
+
+struct traceEvent {
+    const char *name;
+    const char *arg; // NULL when the event has no argument
+    long long value;
+    long long start, dur; // nanoseconds
+};
+
+struct traceBuffer {
+    int tid;
+    int len;
+    struct traceEvent events[TRACE_EVENTS];
+    int depth;
+    struct traceEvent open[TRACE_DEPTH]; // the spans that are still open
+    struct traceBuffer *next; // every thread's buffer, so traceStop() can flush them all
+};
+
+int trace_enabled = 0;
+int trace_fd = -1;
+long long trace_epoch; // timestamps in the file are relative to traceStart()
+__thread struct traceBuffer *trace_buf = NULL;
+struct traceBuffer *trace_buffers = NULL;
+pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER; // only guards the list of buffers
+
+/*** trace ***/
+struct traceBuffer *traceThreadBuffer() {
+    if(trace_buf) return trace_buf;
+    struct traceBuffer *tb = calloc(1, sizeof(struct traceBuffer));
+    if(!tb) return NULL;
+    tb->tid = syscall(SYS_gettid);
+    pthread_mutex_lock(&trace_lock);
+    tb->next = trace_buffers;
+    trace_buffers = tb;
+    pthread_mutex_unlock(&trace_lock);
+    trace_buf = tb;
+    return tb;
+}
+
+void traceFlush(struct traceBuffer *tb) {
+    /* Format the events as JSON and append them with one write(). The file is opened with O_APPEND,
+    so buffers of different threads flushing at the same time don't mix. */
+    if(tb->len == 0) return;
+    size_t cap = tb->len * 160 + 1;
+    char *out = malloc(cap);
+    if(!out) {
+        tb->len = 0;
+        return;
+    }
+    size_t len = 0;
+    for(int i = 0; i < tb->len; i++) {
+        struct traceEvent *ev = &tb->events[i];
+        int n = snprintf(out + len, cap - len, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+            ev->name, tb->tid, (ev->start - trace_epoch) / 1000.0, ev->dur / 1000.0);
+        if(n > 0 && (size_t) n < cap - len) len += n;
+        if(ev->arg) {
+            n = snprintf(out + len, cap - len, ",\"args\":{\"%s\":%lld}", ev->arg, ev->value);
+            if(n > 0 && (size_t) n < cap - len) len += n;
+        }
+        n = snprintf(out + len, cap - len, "},\n");
+        if(n > 0 && (size_t) n < cap - len) len += n;
+    }
+    if(write(trace_fd, out, len) != (ssize_t) len) trace_enabled = 0; // give up on a full disk
+    free(out);
+    tb->len = 0;
+}
+
+int traceStart(const char *path) {
+    trace_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if(trace_fd == -1) return -1;
+    if(write(trace_fd, "[\n", 2) != 2) return -1;
+    trace_epoch = perfNow();
+    trace_enabled = 1;
+    return 0;
+}
+
+void traceStop() {
+    /* Call it once the other threads are done, it flushes their buffers too. */
+    if(trace_fd == -1) return;
+    trace_enabled = 0;
+    pthread_mutex_lock(&trace_lock);
+    for(struct traceBuffer *tb = trace_buffers; tb; tb = tb->next) traceFlush(tb);
+    pthread_mutex_unlock(&trace_lock);
+    // a metadata event closes the array, so that no event needs to know whether it is the last one
+    const char *end = "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"yate\"}}\n]\n";
+    if(write(trace_fd, end, strlen(end)) == -1) {}
+    close(trace_fd);
+    trace_fd = -1;
+}
+
+void traceBegin(const char *name) {
+    if(!trace_enabled) return;
+    struct traceBuffer *tb = traceThreadBuffer();
+    if(!tb) return;
+    if(tb->depth < TRACE_DEPTH) {
+        tb->open[tb->depth].name = name;
+        tb->open[tb->depth].start = perfNow();
+    }
+    tb->depth++; // deeper spans are only counted, so that the ends still match
+}
+
+void traceEndArg(const char *arg, long long value) {
+    /* Close the innermost open span, attaching one numeric argument to it, like the length of a cascade. */
+    struct traceBuffer *tb = trace_buf;
+    if(!trace_enabled || !tb || tb->depth == 0) return;
+    tb->depth--;
+    if(tb->depth >= TRACE_DEPTH) return;
+
+    struct traceEvent *ev = &tb->events[tb->len++];
+    *ev = tb->open[tb->depth];
+    ev->dur = perfNow() - ev->start;
+    ev->arg = arg;
+    ev->value = value;
+    if(tb->len == TRACE_EVENTS) traceFlush(tb);
+}
+
+void traceEnd() {
+    traceEndArg(NULL, 0);
+}
@@ -0,0 +1,25 @@
+#ifndef YATE_TRACE_H
+#define YATE_TRACE_H
+
+/*** trace ***/
+/* Timeline traces of what the editor does, in the Chrome trace-event format, to open in Perfetto
+(ui.perfetto.dev) or chrome://tracing.
+
+Tracing is off until traceStart() is called (yate.c does it when YATE_TRACE=file is set), and then
+every traceBegin()/traceEnd() pair becomes one complete ("X") event, nested under the spans that were
+open around it. Events go into a buffer owned by the calling thread, so recording one is a couple of
+stores and a clock read, with no locks; a full buffer is appended to the file with a single write().
+traceStop() flushes every buffer and closes the JSON array. When tracing is off, each call is one branch.
+
+Names and argument names must be string literals (or live until traceStop()), only the pointers are kept.
+*/
+
+extern int trace_enabled;
+
+int traceStart(const char *path);
+void traceStop();
+void traceBegin(const char *name);
+void traceEnd();
+void traceEndArg(const char *arg, long long value);
+
+#endif
@@ -8,157 +8,31 @@
 #include <ctype.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
 #include <stdio.h>
-#include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/ioctl.h>
 #include <sys/types.h>
 #include <termios.h>
-#include <time.h>
 #include <unistd.h>
 
-
-/* defines */
-
-#define YATE_VERSION "0.0.1"
-#define KILO_TAB_STOP 4
-#define KILO_QUIT_TIMES 3
-
-/* The CTRL_KEY macro bitwise-ANDs a character with the value 00011111, in binary. 
-(In C, you generally specify bitmasks using hexadecimal, since C doesn’t have binary literals)
-
-It sets the upper 3 bits of the character to 0. This mirrors what the Ctrl key does in the terminal: 
-it strips bits 5 and 6 from whatever key you press in combination with Ctrl, and sends that.
-Example:
-    'q' = 113 in decimal, 1110001 in binary
-    113 & 31
-    01110001 & 
-    00011111
-=   00010001
-= 17 (which is the equivalent to Ctrl+q)
-*/
-#define CTRL_KEY(k) ((k) & 0x1f)
-
-/* By setting the first constant in the enum to 1000, the rest of the constants get incrementing values 
-of 1001, 1002, 1003, and so on. */
-enum editorKey {
-    BACKSPACE = 127, // ASCII value, since we can't represent it in C
-    ARROW_LEFT = 1000,
-    ARROW_RIGHT,
-    ARROW_UP,
-    ARROW_DOWN,
-    DEL_KEY, // the escape sequence: <esc>[3~
-    HOME_KEY, // The Home key could be sent as <esc>[1~, <esc>[7~, <esc>[H, or <esc>OH
-    END_KEY, // The End key could be sent as <esc>[4~, <esc>[8~, <esc>[F, or <esc>OF
-    PAGE_UP, // escape sequence: <esc>[5~
-    PAGE_DOWN // escape sequence: <esc>[6~
-};
-
-enum editorHighlight { // possible values that the highlight array can contain.
-    HL_NORMAL = 0,
-    HL_COMMENT,
-    HL_MLCOMMENT,
-    HL_KEYWORD1,
-    HL_KEYWORD2,
-    HL_STRING,
-    HL_NUMBER,
-    HL_MATCH
-};
-
-// flag bits
-#define HL_HIGHLIGHT_NUMBERS (1<<0)
-#define HL_HIGHLIGHT_STRINGS (1<<1)
+#include "alloc.h"
+#include "editor.h"
+#include "pool.h"
+#include "trace.h"
 
 /*** data ***/
-
-struct editorSyntax {
-    char *filetype; // name of the filetype that will be displayed to the user in the status bar
-    char **filematch; // array of strings, where each string contains a pattern to match a filename against
-    char **keywords; // keywords to hightlight
-    char *singleline_comment_start; // each code file could have a different way to start a single-line comment
-    char *multiline_comment_start;
-    char *multiline_comment_end;
-    int flags; // flags is a bit field that will contain flags for whether to highlight numbers and whether to highlight strings for that filetype.
-};
-
-typedef struct errow { // editor row
-    int idx;
-    int size;
-    int rsize; // size of the contents of render
-    char *chars;
-    char *render;
-    unsigned char *highlight; // array to store the highlighting of each line
-    int hl_open_comment; // flag to know if the row is part of an unclosed comment
-} erow;
-struct editorConfig {
-    int cx, cy; // horizontal coordinate and vertical coordinate
-    int rx; // it'll be an index into the render field. If there are no tabs on the current line, then E.rx will be the same as E.cx. If there are tabs, then E.rx will be greater than E.cx
-    int rowoff; // keep track of what row of the file the user is currently scrolled to
-    int coloff; // keep track of what column of the file the user is currently scrolled to
-    struct termios original_terminal;
-    int screenrows;
-    int screencols;
-    int numrows;
-    erow *row; // must be a pointer in order to save multiple line
-    int dirty; // flag, we call a text buffer “dirty” if it has been modified since opening or saving the file
-    char *filename;
-    char statusmsg[80]; // messages to the user, and prompting the user for input when doing a search, for example
-    time_t statusmsg_time;
-    struct editorSyntax *syntax;
-    struct termios orig_termios;
-};
-struct editorConfig E;
-
-/*** filetypes ***/
-char *C_HL_extensions[] = { ".c", ".h", ".cpp", NULL };
-char *C_HLkeywords[] = {
-    // type 1
-    "switch", "if", "while", "for", "break", "continue", "return", "else",
-    "struct", "union", "typedef", "static", "enum", "class", "case",
-    // type 2
-    "int|", "long|", "double|", "float|", "char|", "unsigned|", "signed|",
-    "void|", "size_t|", NULL
-};
-
-struct editorSyntax HLDB[] = { // highlight database
-    {
-        "c", // filetype
-        C_HL_extensions, // filematch
-        C_HLkeywords, // keywords
-        "//", // yes. you know exactly what's going on!
-        "/*",
-        "*/",
-        HL_HIGHLIGHT_NUMBERS | HL_HIGHLIGHT_STRINGS // flags
-    },
-};
-// define an HLDB_ENTRIES constant to store the length of the HLDB array.
-#define HLDB_ENTRIES (sizeof(HLDB) / sizeof(HLDB[0]))
-
-/*** prototypes ***/
-void editorSetStatusMessage(const char *fmt, ...);
-void editorRefreshScreen();
-char *editorPrompt(char *prompt, void (*callback)(char *, int));
+struct termios original_terminal;
+int record_fd = -1; // where to record the input bytes, see YATE_RECORD below
+const char *memreport = NULL; // where to append the memory report on exit, see YATE_MEMREPORT below
 
 /*** terminal ***/
-void die(const char *s) {
-    // reset screen
-    write(STDOUT_FILENO, "\x1b[2J", 4); // clear scren
-    write(STDERR_FILENO, "\x1b[H", 3); // relocate cursor position
-
-    /*Most C library functions that fail will set the global errno variable to indicate what the error was. 
-    perror() looks at the global errno variable and prints a descriptive error message for it.
-
-    It also prints the string given to it before it prints the error message
-    */
-    perror(s);
-    exit(1);
-}
-
-
 void disableRawMode() {
     // we want to disable raw mode when exiting the program in order to keep user with their Terminal "stable".
-    if(tcsetattr(STDIN_FILENO, TCSAFLUSH, &E.original_terminal) == -1) {
+    if(tcsetattr(STDIN_FILENO, TCSAFLUSH, &original_terminal) == -1) {
         die("tcsetattr");
     }
 }
@@ -183,11 +57,11 @@ void enableRawMode() {
     reading input byte-by-byte, instead of line-by-line.
     */
 
-    if(tcgetattr(STDIN_FILENO, &E.original_terminal) == -1) die("tcsetattr");
+    if(tcgetattr(STDIN_FILENO, &original_terminal) == -1) die("tcsetattr");
     // restore to the original value
     atexit(disableRawMode);
 
-    struct termios raw = E.original_terminal;
+    struct termios raw = original_terminal;
     // Update ECHO and CANONICAL mode flags
     /* We want too to handle some key combinations:
         1. Turn off ctrl+c (SIGINT) and ctrl+z (SIGTSTP) signals, which terminates or suspend the program.
@@ -229,64 +103,6 @@ void enableRawMode() {
     if(tcsetattr(STDERR_FILENO, TCSAFLUSH, &raw) == -1) die("tcsetattr");
 }
 
-int editorReadKey() {
-    /* Wait for one keypress, and return it */
-    int nread;
-    char c;
-
-    while((nread = read(STDIN_FILENO, &c, 1)) != 1) {
-        if(nread == -1 && errno != EAGAIN) die("read");
-    }
-
-    //printf("'%c'", c);
-
-    // process arrow keys
-    if(c == '\x1b') {
-        char seq[3];
-
-        if(read(STDIN_FILENO, &seq[0], 1) != 1) return '\x1b';
-        if(read(STDIN_FILENO, &seq[1], 1) != 1) return '\x1b';
-
-        if(seq[0] == '[') {
-            // mapping to be able to move the cursor with narrow keys
-            if(seq[1] >= '0' && seq[1] <= '9') {
-                if(read(STDIN_FILENO, &seq[2], 1) != 1) return '\x1b';
-                if(seq[2] == '~') {
-                    switch(seq[1]) {
-                        case '1': return HOME_KEY;
-                        case '3': return DEL_KEY;
-                        case '4': return END_KEY;
-                        case '5': return PAGE_UP;
-                        case '6': return PAGE_DOWN;
-                        case '7': return HOME_KEY;
-                        case '8': return END_KEY;
-                    }
-                }
-            }
-            else {
-                switch(seq[1]) {
-                    case 'A': return ARROW_UP;
-                    case 'B': return ARROW_DOWN;
-                    case 'C': return ARROW_RIGHT;
-                    case 'D': return ARROW_LEFT;
-                    case 'H': return HOME_KEY;
-                    case 'F': return END_KEY;
-                }
-            }
-        }
-        else if(seq[0] == 'O') {
-            switch(seq[1]) {
-                case 'H': return HOME_KEY;
-                case 'F': return END_KEY;
-            }
-        }
-
-        return '\x1b';
-    }
-
-    return c;
-}
-
 int getCursorPosition(int *rows, int *cols) {
     char buffer[32];
     unsigned int i = 0;
@@ -329,1031 +145,588 @@ int getWindowSize(int *rows, int *cols) {
     }
 }
 
-/*** syntax highlighting ***/
-int is_separator(int c) {
-    /* Takes a character and returns true if it’s considered a separator character.
-
-    strchr() comes from <string.h>. It looks for the first occurrence of a character in a string, 
-    and returns a pointer to the matching character in the string. If the string doesn’t contain the character, 
-    strchr() returns NULL.
-    */
-    return isspace(c) || c == '\0' || strchr(",.()+-/*=~%<>[];", c) != NULL;
-}
-
-void editorUpdateSyntax(erow *row) {
-    /*** go through the characters of an erow and highlight them by setting each value in the highlight array. ***/
-    row->highlight = realloc(row->highlight, row->rsize);
-    // et all characters to HL_NORMAL by default, before looping through the characters and setting the digits to HL_NUMBER. 
-    memset(row->highlight, HL_NORMAL, row->rsize);
-
-    if (E.syntax == NULL) return;
-
-    char **keywords = E.syntax->keywords;
-
-    // single-line comments (aliases)
-    char *sc_start = E.syntax->singleline_comment_start;
-    int scs_len = sc_start ? strlen(sc_start) : 0;
-    // multi-line comments (aliases)
-    char *mc_start = E.syntax->multiline_comment_start;
-    char *mc_end = E.syntax->multiline_comment_end;
-    int mcs_len = mc_start ? strlen(mc_start) : 0;
-    int mce_len = mc_end ? strlen(mc_end) : 0;
-
-    int prev_separator = 1; // we consider the beginning of the line to be a separator
-    int in_string = 0;
-    /*initialize in_comment to true if the previous row has an unclosed multi-line comment. 
-    If that’s the case, then the current row will start out being highlighted as a multi-line comment.*/
-    int in_comment = (row->idx > 0 && E.row[row->idx - 1].hl_open_comment);
-
-    int i = 0;
-    while(i < row->rsize) {
-        char c = row->render[i];
-        unsigned char prev_hl = (i > 0) ? row->highlight[i - 1] : HL_NORMAL;
-
-        if(scs_len && !in_string && !in_comment) {
-            if(!strncmp(&row->render[i], sc_start, scs_len)) {
-                memset(&row->highlight[i], HL_COMMENT, row->rsize - i);
-                break; // we asume the rest of the line is all part of the comment, yes!
-            }
-        }
-
-        if(mcs_len && mce_len && !in_string) {
-            if(in_comment) {
-                row->highlight[i] = HL_MLCOMMENT;
-                if (!strncmp(&row->render[i], mc_end, mce_len)) {
-                    memset(&row->highlight[i], HL_MLCOMMENT, mce_len);
-                    i += mce_len;
-                    in_comment = 0;
-                    prev_separator = 1;
-                    continue;
-                }
-
-                i++;
-                continue;
-            }
-            else if(!strncmp(&row->render[i], mc_start, mcs_len)) {
-                memset(&row->highlight[i], HL_MLCOMMENT, mcs_len);
-                i += mcs_len;
-                in_comment = 1;
-                continue;
-            }
-        }
-
-        // we highlight both double-quoted strings and single-quoted strings
-        if(E.syntax->flags & HL_HIGHLIGHT_STRINGS) {
-            if(in_string) {
-                row->highlight[i] = HL_STRING;
-
-                // take escaped quotes into account
-                if (c == '\\' && i + 1 < row->rsize) {
-                    row->highlight[i + 1] = HL_STRING;
-                    i += 2;
-                    continue;
-                }
-
-                if(c == in_string) in_string = 0; // here ends the string
-                i++;
-                prev_separator = 1; // the closing quote is considered a separator.
-                continue;
-            }
-            else {
-                if(c == '"' || c == '\'') {
-                    // We store either a double-quote (") or a single-quote (') character as the value of in_string, 
-                    // so that we know which one closes the string.
-                    in_string = c;
-                    row->highlight[i] = HL_STRING;
-                    i++;
-                    continue;
-                }
-            }
-        }
-
-        if(E.syntax->flags & HL_HIGHLIGHT_NUMBERS) {
-            if((isdigit(c) && (prev_separator || prev_hl == HL_NUMBER)) 
-                || (c == '.' && prev_hl == HL_NUMBER)
-            ) {
-                row->highlight[i] = HL_NUMBER;
-                i++;
-                prev_separator = 0;
-                continue;
-            }
-        }
-
-        if(prev_separator) {
-            int j;
-            for (j = 0; keywords[j]; j++) {
-                int klen = strlen(keywords[j]);
-                int kw2 = keywords[j][klen - 1] == '|'; // detect keywords type 2
-                if(kw2) klen--; // discard pipe from keyword lenght
-
-                if(!strncmp(&row->render[i], keywords[j], klen) && is_separator(row->render[i + klen])) {
-                    memset(&row->highlight[i], kw2 ? HL_KEYWORD2 : HL_KEYWORD1, klen);
-                    i += klen;
-                    break;
-                }
-            }
-            if(keywords[j] != NULL) { // check if a keyword was highligthed (break out from the prev for loop)
-                prev_separator = 0;
-                continue;
-            }
-        }
+/*** allocation report ***/
+const char *allocreport = NULL; // where to append the allocation report on exit, see YATE_ALLOC_REPORT below
 
-        prev_separator = is_separator(c);
-        i++;
-    }  
-    /*So far, we have only been updating the syntax of a line when the user changes that specific line. 
-    But with multi-line comments, a user could comment out an entire file just by changing one line. 
-    So it seems like we need to update the syntax of all the lines following the current line. 
-    However, we know the highlighting of the next line will not change if the value of this line’s 
-    hl_open_comment did not change. So we check if it changed, and only call editorUpdateSyntax() 
-    on the next line if hl_open_comment changed (and if there is a next line in the file).
-    */
-    int changed = (row->hl_open_comment != in_comment);
-    row->hl_open_comment = in_comment;
-    if(changed && row->idx + 1 < E.numrows)
-        editorUpdateSyntax(&E.row[row->idx + 1]);
-}
-
-int editorSyntaxToColor(int hl) {
-    /***maps values in hl to the actual ANSI color codes we want to draw them with.*/
-    switch (hl) {
-        case HL_COMMENT: 
-        case HL_MLCOMMENT: return 36; // cyan
-        case HL_KEYWORD1: return 33; // yellow
-        case HL_KEYWORD2: return 32; // green
-        case HL_STRING: return 35; // magenta
-        case HL_NUMBER: return 31; // red
-        case HL_MATCH: return 34; // blue
-        default: return 37; // white
-    }
-}
-
-void editorSelectSyntaxHighlight() {
-    E.syntax = NULL;
-    if(E.filename == NULL) return;
-
-    char *extension = strrchr(E.filename, '.');
-
-    for (unsigned int j = 0; j < HLDB_ENTRIES; j++) {
-        struct editorSyntax *s = &HLDB[j];
-        unsigned int i = 0;
-        while (s->filematch[i]) {
-            int is_ext = (s->filematch[i][0] == '.');
-            // strrchr() returns a pointer to the last occurrence of a character in a string,
-            // strcmp() returns 0 if two given strings are equal.
-            if ((is_ext && extension && !strcmp(extension, s->filematch[i])) ||
-                (!is_ext && strstr(E.filename, s->filematch[i]))) {
-                E.syntax = s;
-                
-                int filerow;
-                for (filerow = 0; filerow < E.numrows; filerow++) {
-                    editorUpdateSyntax(&E.row[filerow]);
-                }
-                return;
-            }
-            i++;
-        }
-    }
+void writeAllocReport() {
+    FILE *fp = fopen(allocreport, "a");
+    if(!fp) return;
+    allocReport(fp, 20);
+    fclose(fp);
 }
 
-/*** Row operations ***/
-int editorRowCxToRx(erow *row, int cx) {
-    // convert char position to render position
-    int rx = 0;
-    for(int j = 0; j < cx; j++) {
-        if(row->chars[j] == '\t') {
-            rx += (KILO_TAB_STOP - 1) - (rx % KILO_TAB_STOP);
-        }
-        rx++;
-    }
+/*** output queue ***/
+/* The frames are written without blocking, so a slow terminal (or link to it) never stops the editor in write().
+O_NONBLOCK belongs to the open file description, which stdout shares with the shell: set on stdout, a crash would
+leave the shell a terminal that doesn't block. So the queue writes to the tty opened again (outputOpen()), with a
+description of its own; if that can't be done, to stdout, blocking. What doesn't go out at once waits here, and
+ttyRead() sends it as soon as the terminal can take more. Each ttyWrite() is a frame, and frames only make sense
+whole: the one on its way (out_now) goes out to the end, but a frame that hasn't started yet (out_next) is replaced
+by the next one, which draws the screen again anyway. So at most two are queued. */
+struct outputFrame {
+    char *b;
+    int len;
+    int sent;
+    int probed; // flag, it ends with a request of outputProbe()
+    long long input; // latency_input of the keys it shows, until it's all written; 0 when not measured
+};
+struct outputFrame out_now, out_next;
+void latencyFrameWritten(struct outputFrame *frame); // see the latency section
+int output_fd = STDOUT_FILENO; // where the frames are written, see outputOpen()
 
-    return rx;
+void outputOpen() {
+    const char *tty = ttyname(STDOUT_FILENO);
+    int fd = tty ? open(tty, O_WRONLY | O_NONBLOCK | O_NOCTTY | O_CLOEXEC) : -1;
+    if(fd != -1) output_fd = fd;
 }
 
-int editorRowRxToCx(erow *row, int rx) {
-    // convert render position in the row to char position
-    int cur_rx = 0;
-    int cx;
-
-    for(cx = 0; cx < row->size; cx++) {
-        if(row->chars[cx] == '\t') {
-            cur_rx += (KILO_TAB_STOP - 1) - (cur_rx % KILO_TAB_STOP);
-        }
-        cur_rx++;
-
-        if(cur_rx > rx) return cx;
-    }
-    // just in case the caller provided an rx that’s out of range, which shouldn’t happen.
-    return cx;
+int outputQueued() {
+    return out_now.len - out_now.sent + out_next.len;
 }
 
-void editorUpdateRow(erow *row) {
-    int tabs = 0;
-    int j;
-    /* The maximum number of characters needed for each tab is 4. row->size already counts 1 for each tab, 
-    so we multiply the number of tabs by 3 and add that to row->size to get the maximum amount of memory 
-    we’ll need for the rendered row.
-    */
-    for(j = 0; j < row->size; j++) {
-        if(row->chars[j] == '\t') tabs++;
-    }
-
-    free(row->render);
-    row->render = malloc(row->size + tabs*(KILO_TAB_STOP-1) + 1);
-
-    int idx = 0;
-    // copy the from chars to render
-    for(j = 0; j < row->size; j++) {
-        if(row->chars[j] == '\t') {
-            row->render[idx++] = ' ';
-            while(idx % KILO_TAB_STOP != 0) row->render[idx++] = ' ';
+void outputFlush() {
+    /* Write as much as stdout takes without waiting. */
+    while(outputQueued() > 0) {
+        if(out_now.sent == out_now.len) { // the next frame starts going out
+            yateFree(out_now.b);
+            out_now = out_next;
+            memset(&out_next, 0, sizeof(out_next));
         }
-        else {
-            row->render[idx++] = row->chars[j];
+        ssize_t nwritten = write(output_fd, &out_now.b[out_now.sent], out_now.len - out_now.sent);
+        if(nwritten == -1 && errno == EINTR) continue;
+        if(nwritten == -1 && errno != EAGAIN) { // the terminal is gone, nothing will go out any more
+            out_now.sent = out_now.len;
+            yateFree(out_next.b);
+            memset(&out_next, 0, sizeof(out_next));
         }
+        if(nwritten <= 0) return;
+        out_now.sent += nwritten;
+        if(out_now.sent == out_now.len && out_now.input) latencyFrameWritten(&out_now);
     }
-    row->render[idx] = '\0';
-    row->rsize = idx;
-
-    editorUpdateSyntax(row);
 }
 
-void editorInsertRow(int at, char *s, size_t len) {
-    if(at < 0 || at > E.numrows) return;
-
-    E.row = realloc(E.row, sizeof(erow) * (E.numrows + 1));
-    // dest, origin and num_bytes (size of the block to move)
-    memmove(&E.row[at + 1], &E.row[at], sizeof(erow) * (E.numrows - at));
-    // update the index of below rows
-    for (int j = at + 1; j <= E.numrows; j++) E.row[j].idx++;
-
-    E.row[at].idx = at;
-
-    E.row[at].size = len;
-    E.row[at].chars = malloc(len + 1); // reserve the memory for the message
-    memcpy(E.row[at].chars, s, len); // copy the message to chars
-    E.row[at].chars[len] = '\0';
-    E.row[at].rsize = 0;
-    E.row[at].render = NULL;
-    E.row[at].highlight = NULL;
-    E.row[at].hl_open_comment = 0;
-    editorUpdateRow(&E.row[at]);
-
-    E.numrows++; // a line must be displayed now
-    E.dirty++;
-}
-
-void editorFreeRow(erow *row) {
-    free(row->render);
-    free(row->chars);
-    free(row->highlight);
-}
-
-void editorDelRow(int at) {
-    if(at < 0 || at >= E.numrows) return;
-    editorFreeRow(&E.row[at]);
-    // dest, origin and num_bytes (size of the block to move, including null char at the end)
-    memmove(&E.row[at], &E.row[at + 1], sizeof(erow) * (E.numrows - at - 1));
-    // update the index of below rows
-    for (int j = at; j < E.numrows - 1; j++) E.row[j].idx--;
-    E.numrows--;
-    E.dirty++;
-}
-
-
-void editorRowInsertChar(erow *row, int at, int c) {
-    if(at < 0 || at > row->size) at = row->size;
-    row->chars = realloc(row->chars, row->size + 2); // add 2 because we also have to make room for the null byte
-    // It is like memcpy(), but is safe to use when the source and destination arrays overlap.
-    // dest, origin and num_bytes (size of the block to move, including null char at the end)
-    memmove(&row->chars[at + 1], &row->chars[at], row->size - at + 1);
-    /* Use memmove() to make room for the new character. 
-    We increment the size of the chars array, and then actually assign the character to its position in the array.
-    */
-    row->size++;
-    row->chars[at] = c;
-    editorUpdateRow(row);
-
-    E.dirty++;
-}
-
-void editorRowAppendString(erow *row, char *s, size_t len) {
-    row->chars = realloc(row->chars, row->size + len + 1); // reserve space of the new s (string) + null byte
-    memcpy(&row->chars[row->size], s, len); // copy s to the end of chars
-    row->size += len; // update new len
-    row->chars[row->size] = '\0'; // add null byte
-    editorUpdateRow(row);
-    E.dirty++;
-}
-
-
-void editorRowDelChar(erow *row, int at) {
-    /* Deletes a character in a row*/
-    if(at < 0 || at >= row->size) return;
-    // Use memmove() to overwrite the deleted character with the characters that come after it (the null byte at the end gets included)
-    // dest, origin and num_bytes
-    memmove(&row->chars[at], &row->chars[at + 1], row->size - at);
-    row->size--;
-    editorUpdateRow(row);
-    E.dirty++;
-}
-
-
-/*** Editor Operations ***/
-void editorInsertChar(int c) {
-    if(E.cy == E.numrows) { // if we are at the end of the file, add an extra row to write there
-        editorInsertRow(E.numrows, "", 0);
+void outputDrain() {
+    /* Wait until everything queued is out: before a request that needs an answer, and on exit. */
+    while(outputQueued() > 0) {
+        struct pollfd pfd = { output_fd, POLLOUT, 0 };
+        if(poll(&pfd, 1, 100) == -1 && errno != EINTR) return;
+        outputFlush();
     }
-    editorRowInsertChar(&E.row[E.cy], E.cx, c);
-    E.cx++;
 }
 
+/*** latency ***/
+/* YATE_LATENCY=file measures the keystroke-to-photon latency of the session and appends a report to file on exit.
 
-void editorInsertNewLine() {
-    if(E.cx == 0) {
-        editorInsertRow(E.cy, "", 0);
-    }
-    else {
-        erow *row = &E.row[E.cy];
-        editorInsertRow(E.cy + 1, &row->chars[E.cx], row->size - E.cx);
-        row = &E.row[E.cy];
-        row->size = E.cx;
-        row->chars[row->size] = '\0';
-        editorUpdateRow(row);
-    }
-    E.cy++;
-    E.cx = 0;
-}
-
-
-void editorDelChar() {
-    /* If the cursor’s past the end of the file, then there is nothing to delete, and we return.
-    Otherwise, we get the erow the cursor is on, and if there is a character to the left 
-    of the cursor, we delete it and move the cursor one to the left.
-    */
-    if(E.cy == E.numrows) return;
-    // unable to get "up" the current row
-    if(E.cx == 0 && E.cy == 0) return; 
-
-    erow *row = &E.row[E.cy];
-    if(E.cx > 0) {
-        editorRowDelChar(row, E.cx - 1);
-        E.cx--;
-    }
-    // beggining of the line, we want to get "up" the row and concat the content with the previous one
-    else {
-        E.cx = E.row[E.cy - 1].size;
-        editorRowAppendString(&E.row[E.cy - 1], row->chars, row->size);
-        editorDelRow(E.cy);
-        E.cy--;
-    }
-}
-
-
-/*** file I/O ***/
-char *editorRowsToString(int *buflen) {
-    int totlen = 0;
-    for (int j = 0; j < E.numrows; j++) {
-        totlen += E.row[j].size + 1; // plus 1 since we count the end of line after each lines
-    }
-
-    *buflen = totlen;
-    char *buf = malloc(totlen);
-    char *pointer = buf;
-
-    for (int j = 0; j < E. numrows; j++) {
-        /*memcpy() the contents of each row to the end of the buffer, appending a newline character after each row.
-        */
-        memcpy(pointer, E.row[j].chars, E.row[j].size);
-        pointer += E.row[j].size;
-        *pointer = '\n';
-        pointer++;
-    }
-
-    return buf;
-}
-
-
-void editorSave() {
-    if(E.filename == NULL) {
-        E.filename = editorPrompt("Save as: %s (ESC to cancel)", NULL);
-        if(E.filename == NULL) {
-            editorSetStatusMessage("Save aborted");
-            return;
-        }
-        editorSelectSyntaxHighlight();
-    }
-
-    int len;
-    char *buf = editorRowsToString(&len);
-
-    /* We want to create a new file if it doesn’t already exist (O_CREAT), and we want to open it for reading and writing (O_RDWR).
-     * Because we used the O_CREAT flag, we have to pass an extra argument containing the mode (the permissions) the new file
-     * should have. 0644 is the standard permissions you usually want for text files. It gives the owner of the file permission
-     * to read and write the file, and everyone else only gets permission to read the file.
-    */
-    int fd = open(E.filename, O_RDWR | O_CREAT, 0644);
-    /* sets the file’s size to the specified length. If the file is larger than that, it will cut off any data
-    at the end of the file to make it that length. If the file is shorter, it will add 0 bytes at the end to
-    make it that length.
-    */
-    if (fd != -1) {
-        if(ftruncate(fd, len) != -1) {
-            if(write(fd, buf, len) == len) {
-                close(fd);
-                free(buf);
-                E.dirty = 0;
-                editorSetStatusMessage("%d bytes written to disk", len);
-                return;
-            }
+The clock starts when read() returns the first byte of a batch of input, and stops when write() has handed
+the last byte of the next frame to the terminal, which may be a while after it was queued (see the output queue):
+a frame replaced before it started going out isn't measured. That is as far as the editor can see: the terminal (and the ssh connection,
+or the network link, in between) still has to parse and paint it. With YATE_LATENCY_PROBE=1, every frame is
+followed by a Device Status Report request, like getCursorPosition() does. The terminal answers it only after
+it has processed everything before it, so the answer shows when the frame really got there. Keys typed while
+waiting for the answer are kept and handed to the editor afterwards.
+*/
+const char *latency_report = NULL;
+int latency_probe = 0;
+long long latency_input = 0; // when the pending input batch arrived, 0 when there is none
+struct perfHistogram latency_frame; // input read -> frame written
+struct perfHistogram latency_terminal; // input read -> the terminal answered the probe after the frame
+struct perfHistogram latency_roundtrip; // frame written -> the terminal answered the probe
+char pushback[256]; // input read but not handed to the editor yet: see ttyRead(), latencyProbe() and ttyInterrupt()
+int pushback_len = 0;
+long long pushback_at = 0; // when the first byte in pushback arrived
+
+void latencyPushback(const char *s, int len, long long at) {
+    if(len > (int) sizeof(pushback) - pushback_len) len = sizeof(pushback) - pushback_len;
+    if(len <= 0) return;
+    if(pushback_len == 0) pushback_at = at;
+    memcpy(&pushback[pushback_len], s, len);
+    pushback_len += len;
+}
+
+long long latencyProbe() {
+    /* Right after a frame went out whole: ask for the cursor position and wait (up to a second) for the answer,
+    <esc>[rows;colsR. Returns when it arrived, or 0 when it didn't. Everything else read meanwhile goes to pushback. */
+    if(write(STDOUT_FILENO, "\x1b[6n", 4) != 4) return 0;
+
+    char in[64];
+    int len = 0;
+    long long deadline = perfNow() + 1000000000LL;
+    long long first = 0;
+    while(len < (int) sizeof(in) && perfNow() < deadline) {
+        struct pollfd pfd = { STDIN_FILENO, POLLIN, 0 };
+        if(poll(&pfd, 1, 10) <= 0 || read(STDIN_FILENO, &in[len], 1) != 1) continue;
+        if(!first) first = perfNow();
+        len++;
+        if(in[len - 1] != 'R') continue;
+
+        // the answer is the last escape sequence, anything before it was typed by the user
+        int start = len - 1;
+        while(start > 0 && in[start] != '\x1b') start--;
+        int r, c;
+        char end;
+        if(in[start] == '\x1b' && sscanf(&in[start], "\x1b[%d;%d%c", &r, &c, &end) == 3 && end == 'R') {
+            long long now = perfNow();
+            latencyPushback(in, start, first);
+            return now;
         }
-        close(fd);
     }
-
-    free(buf);
-    editorSetStatusMessage("Can't save! I/O error: %s", strerror(errno));
+    latencyPushback(in, len, first);
+    return 0;
 }
 
-/*** find ***/
-void editorFindCallback(char *query, int key) {
-    // declare variables to support advance to the next or previous match in the file
-    static int last_match = -1; // contain the index of the row that the last match was on, or -1 if there was no last match
-    static int direction = 1; // store the direction of the search: 1 for searching forward, and -1 for searching backward.
-
-    static int saved_hl_line;
-    static char *saved_hl = NULL;
-
-    if(saved_hl) {
-        memcpy(E.row[saved_hl_line].highlight, saved_hl, E.row[saved_hl_line].rsize);
-        free(saved_hl);
-        saved_hl = NULL;
-    }
-
-    if(key == '\r' || key == '\x1b') {
-        last_match = -1;
-        direction = 1;
-        return;
-    }
-    else if(key == ARROW_RIGHT || key == ARROW_DOWN) direction = 1;
-    else if(key == ARROW_LEFT  || key == ARROW_UP) direction = -1;
-    else {
-        last_match = -1;
-        direction = 1;
-    }
-
-    if(last_match == -1) direction = 1;
-    int current = last_match; // index of the current row we are searching
-
-    int i;
-    for (i = 0; i < E.numrows; i++) {
-        current += direction;
-        // wrap around
-        if(current == -1) current = E.numrows - 1;
-        else if(current == E.numrows) current = 0;
-
-        erow *row = &E.row[current];
-        char *match = strstr(row->render, query); // check if query is a substring of the current row
-        if(match) {
-            last_match = current;
-            E.cy = current;
-            E.cx = editorRowRxToCx(row, match - row->render);
-            /***  we set E.rowoff so that we are scrolled to the very bottom of the file, which will cause 
-             * editorScroll() to scroll upwards at the next screen refresh so that the matching line will be at 
-             * the very top of the screen 
-            ***/
-            E.rowoff = E.numrows;
-            // save current highlight
-            saved_hl_line = current;
-            saved_hl = malloc(row->rsize);
-            memcpy(saved_hl, row->highlight, row->rsize);
-
-            // highlight match search
-            memset(&row->highlight[match - row->render], HL_MATCH, strlen(query));
-            break;
+void latencyFrameWritten(struct outputFrame *frame) {
+    /* The last byte of frame was just written: that's when the keys it shows got out of the editor. */
+    long long written = perfNow(), input = frame->input;
+    frame->input = 0;
+    perfHistogramAdd(&latency_frame, written - input);
+    if(latency_probe) {
+        long long answered = latencyProbe();
+        if(answered) {
+            perfHistogramAdd(&latency_terminal, answered - input);
+            perfHistogramAdd(&latency_roundtrip, answered - written);
         }
     }
 }
 
-void editorFind() {
-    /*** When the user presses Escape to cancel a search, we want the cursor to go back to where it was when 
-     * they started the search*/
-    int saved_cx = E.cx;
-    int saved_cy = E.cy;
-    int saved_coloff = E.coloff;
-    int saved_rowoff = E.rowoff;
-
-    char *query = editorPrompt("Search: %s (Use ESC/Arrows/Enter)", editorFindCallback);
-
-    if(query) {
-        free(query);
-    }
-    else {
-        E.cx = saved_cx;
-        E.cy = saved_cy;
-        E.coloff = saved_coloff;
-        E.rowoff = saved_rowoff;
+void writeLatencyReport() {
+    FILE *fp = fopen(latency_report, "a");
+    if(!fp) return;
+    const char *term = getenv("TERM");
+    fprintf(fp, "yate latency report: TERM=%s, probe %s\n", term ? term : "?", latency_probe ? "on" : "off");
+    perfHistogramPrint(&latency_frame, "input read -> frame written", fp);
+    if(latency_probe) {
+        perfHistogramPrint(&latency_terminal, "input read -> frame processed by the terminal", fp);
+        perfHistogramPrint(&latency_roundtrip, "frame written -> frame processed by the terminal", fp);
     }
-}
-
-
-void editorOpen(char *filename) {
-    free(E.filename);
-    // makes a copy of the given string, allocating the required memory and assuming you will free() that memory
-    E.filename = strdup(filename);
-
-    editorSelectSyntaxHighlight();
-
-    FILE *fp = fopen(filename, "r");
-    if(!fp) die("fopen");
-
-    char *line = NULL;
-    size_t linecap = 0;
-    ssize_t linelen;
-    // getline() is useful for reading lines from a file when we don’t know how much memory to allocate
-    // for each line. It takes care of memory management for you. First, we pass it a null line pointer
-    // and a linecap (line capacity) of 0. That makes it allocate new memory for the next line it reads,
-    // and set line to point to the memory, and set linecap to let you know how much memory it allocated.
-    // Its return value is the length of the line it read, or -1 if it’s at the end of the file
-    while((linelen = getline(&line, &linecap, fp)) != -1) {
-        // strip off the newline or carriage return at the end of the line before copying it into our erow
-        while(linelen > 0 && (line[linelen - 1] == '\n' || line[linelen - 1] == '\r')) {
-            linelen--;
-        }
-
-        editorInsertRow(E.numrows, line, linelen);
-    }
-    free(line);
     fclose(fp);
-
-    E.dirty = 0;
-}
-
-/*** append buffer ***/
-/* It would be better to do one big write(), to make sure the whole screen updates at once.
-Otherwise there could be small unpredictable pauses between write()’s, which would cause an
-annoying flicker effect.
-
-We want to replace all our write() calls with code that appends the string to a buffer, 
-and then write() this buffer out at the end.
-*/
-struct abuf {
-    char* b;
-    int len;
-};
-// An append buffer consists of a pointer to our buffer in memory, and a length
-#define ABUF_INIT {NULL, 0}
-
-void abAppend(struct abuf *ab, const char *s, int len) {
-    // make sure we allocate enough memory to hold the new string.
-    char *new = realloc(ab->b, ab->len + len);
-
-    if(new == NULL) return;
-    /* copy the string s after the end of the current data in the buffer, and we update the pointer
-    and length of the abuf to the new values */
-    memcpy(&new[ab->len], s, len);
-    ab->b = new;
-    ab->len += len;
-}
-
-void abFree(struct abuf *ab) {
-    free(ab->b);
-}
-
-/** output ***/
-void editorScroll() {
-    E.rx = E.cx;
-    if (E.cy < E.numrows) {
-        E.rx = editorRowCxToRx(&E.row[E.cy], E.cx);
-    }
-
-    /* The first if statement checks if the cursor is above the visible window,
-    and if so, scrolls up to where the cursor is. The second if statement checks if the cursor
-    is past the bottom of the visible window, and contains slightly more complicated arithmetic 
-    because E.rowoff refers to what’s at the top of the screen.
-    */
-    if(E.cy < E.rowoff) {
-        E.rowoff = E.cy;
-    }
-    if(E.cy >= E.rowoff + E.screenrows) {
-        E.rowoff = E.cy - E.screenrows + 1;
-    }
-    // horizontal scrolling
-    if(E.rx < E.coloff) {
-        E.coloff = E.rx;
-    }
-    if(E.rx >= E.coloff + E.screencols) {
-        E.coloff = E.rx - E.screencols + 1;
-    }
-}
-
-void editorDrawRows(struct abuf *ab) {
-    int y;
-    for(y = 0; y < E.screenrows; y++) {
-        int filerow = y + E.rowoff;
-        if(filerow >= E.numrows) { // check whether we are currently drawing a row that is part of the text buffer
-            if(E.numrows == 0 && y == E.screenrows / 3) {
-                // write a WELCOME message
-                char welcome[80];
-                /*We use the welcome buffer and snprintf() to interpolate our YATE_VERSION string into 
-                the welcome message*/
-                int welcomelen = snprintf(welcome, sizeof(welcome), "Yate Editor -- version %s", YATE_VERSION);
-
-                if(welcomelen > E.screencols) welcomelen = E.screencols;
-
-                // center the message
-                int padding = (E.screencols - welcomelen) / 2;
-                if(padding) {
-                    abAppend(ab, "~", 1);
-                    padding--;
-                }
-                while(padding--) abAppend(ab, " ", 1);
-
-                abAppend(ab, welcome, welcomelen);
-            }
-            else {
-                // write(STDOUT_FILENO, "~", 1); // write tilde for each visible row
-                abAppend(ab, "~", 1);
-            }
-        }
-        else {
-            int len = E.row[filerow].rsize - E.coloff;
-            if(len < 0) len = 0;
-            if(len > E.screencols) len = E.screencols; // truncate the line if it's necessary
-            
-            // color red digits
-            char *c = &E.row[filerow].render[E.coloff];
-            unsigned char *hl = &E.row[filerow].highlight[E.coloff]; // to the slice of the hightligh array that corresponds to the slice of render that we are printing
-            int current_color = -1; // track current char to minimize printing scape sequences
-            int j;
-            for(j = 0; j < len; j++) {
-                if(iscntrl(c[j])) { // check if the current character is a control character
-                    char sym = (c[j] <= 26) ? '@' + c[j] : '?'; // try to convert it to printable character
-                    abAppend(ab, "\x1b[7m", 4); // invert colors
-                    abAppend(ab, &sym, 1);
-                    abAppend(ab, "\x1b[m", 3); // restore colors
-
-                    // since <esc>[m turns off all text formatting, including colors. So let’s print the escape sequence for the current color afterwards.
-                    if(current_color != -1) {
-                        char buf[16];
-                        int clen = snprintf(buf, sizeof(buf), "\x1b[%dm", current_color);
-                        abAppend(ab, buf, clen);
-                    }
-                }
-                else if(hl[j] == HL_NORMAL) {
-                    if(current_color != -1) {
-                        abAppend(ab, "\x1b[39m", 5);
-                        current_color = -1;
-                    }
-                    abAppend(ab, &c[j], 1); // actual character
-                }
-                else {
-                    int color = editorSyntaxToColor(hl[j]);
-                    if(color != current_color) {
-                        current_color = color;
-                        char buf[16];
-                        int color_len = snprintf(buf, sizeof(buf), "\x1b[%dm", color); // write the escape sequence into a buffer
-                        abAppend(ab, buf, color_len);
-                    }
-                    abAppend(ab, &c[j], 1); // actual digit
-                }
-            }
-            abAppend(ab, "\x1b[39m", 5); // reset to default text color
-        }
-        /* The K command (Erase In Line) erases part of the current line. 
-        Its argument is analogous to the J command’s argument: 2 erases the whole line, 
-        1 erases the part of the line to the left of the cursor, 
-        and 0 erases the part of the line to the right of the cursor (default)
-        */
-        abAppend(ab, "\x1b[K", 3); // clear each line as we redraw it
-        // and for all except the last line, print \r\n
-        // if(y < E.screenrows - 1) {
-        //     abAppend(ab, "\r\n", 2);
-        // }
-
-        abAppend(ab, "\r\n", 2);
-    }
 }
 
-
-void editorDrawStatusBar(struct abug *ab) {
-    /*To make the status bar stand out, we’re going to display it with inverted colors: 
-    black text on a white background. The escape sequence <esc>[7m switches to inverted colors, 
-    and <esc>[m switches back to normal formatting.
-
-    The m command (Select Graphic Rendition) causes the text printed after it to be printed 
-    with various possible attributes including normal (0), bold (1), underscore (4), blink (5), and inverted colors (7). 
-    For example, you could specify all of these attributes using the command <esc>[1;4;5;7m.
-    */
-    abAppend(ab, "\x1b[7m", 4);
-
-    char status[80], rstatus[80];
-    // display max 20 chars from filename
-    int len = snprintf(status, sizeof(status), "%.20s - %d lines %s",
-    E.filename ? E.filename : "[No Name]", E.numrows,
-    E.dirty ? "(modified)" : "");
-
-    // print the filetype and the actual row position in the file
-    int rlen = snprintf(rstatus, sizeof(rstatus), "%s | %d/%d", 
-        E.syntax ? E.syntax->filetype : "no ft", E.cy + 1, E.numrows);
-
-    if(len > E.screencols) len = E.screencols;
-    abAppend(ab, status, len);
-
-    while(len < E.screencols) {
-        if(E.screencols - len == rlen) {
-            abAppend(ab, rstatus, rlen);
-            break;
+/*** resize ***/
+/* The terminal sends SIGWINCH when its window changes size. Not much is safe to do in a signal handler, so it only
+writes a byte to a pipe (the self-pipe trick): ttyRead() waits on that pipe as well as on the keyboard, and
+wakes up the main loop, which asks for the new size with ttyResized(). A burst of signals while the user drags
+the window piles up in the pipe, and is drained by one call, so it costs a single repaint. */
+int winch_pipe[2] = { -1, -1 };
+
+void ttyWinch(int sig) {
+    (void) sig;
+    int saved_errno = errno; // the handler may interrupt code that looks at errno right after a call
+    if(write(winch_pipe[1], "w", 1) == -1) {} // the pipe is full: there's a resize to handle already
+    errno = saved_errno;
+}
+
+void watchResize() {
+    if(pipe(winch_pipe) == -1) return;
+    for(int i = 0; i < 2; i++) fcntl(winch_pipe[i], F_SETFL, fcntl(winch_pipe[i], F_GETFL) | O_NONBLOCK);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = ttyWinch;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGWINCH, &sa, NULL);
+}
+
+int ttyResized(int *rows, int *cols) {
+    char drain[64];
+    int signalled = 0;
+    while(winch_pipe[0] != -1 && read(winch_pipe[0], drain, sizeof(drain)) > 0) signalled = 1;
+    return signalled && getWindowSize(rows, cols) == 0;
+}
+
+/*** memory pressure ***/
+/* Linux measures how long tasks stall waiting for memory (pressure stall information, PSI). A trigger written to a
+memory.pressure file makes poll() report POLLPRI once tasks stalled for more than a threshold within a window.
+The cgroup of the editor is watched, since that's where a container's limit applies, or the whole system when
+there is no cgroup v2. ttyRead() waits on the trigger with the keyboard, and the editor gives back what it can
+rebuild (see editorMemoryCheck()). Unprivileged triggers need a window that is a multiple of 2 s. */
+#define PRESSURE_TRIGGER "some 150000 2000000" // stalled 150 ms within 2 s
+int pressure_fd = -1;
+int pressure_fired = 0; // flag, the trigger fired since the last ttyPressure()
+
+int pressureOpen(const char *path) {
+    int fd = open(path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if(fd == -1) return -1;
+    if(write(fd, PRESSURE_TRIGGER, strlen(PRESSURE_TRIGGER) + 1) == -1) { // PSI disabled, or not allowed
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void watchMemoryPressure() {
+    FILE *fp = fopen("/proc/self/cgroup", "r");
+    if(fp) {
+        char line[PATH_MAX], path[PATH_MAX + 64];
+        while(pressure_fd == -1 && fgets(line, sizeof(line), fp)) {
+            if(strncmp(line, "0::", 3)) continue; // the cgroup v2 entry
+            line[strcspn(line, "\n")] = '\0';
+            snprintf(path, sizeof(path), "/sys/fs/cgroup%s/memory.pressure", &line[3]);
+            pressure_fd = pressureOpen(path);
+            if(pressure_fd != -1) break;
+            // where systemd mounts cgroup v2 next to v1 (the "hybrid" layout)
+            snprintf(path, sizeof(path), "/sys/fs/cgroup/unified%s/memory.pressure", &line[3]);
+            pressure_fd = pressureOpen(path);
         }
-        else {
-            abAppend(ab, " ", 1);
-            len++;
+        fclose(fp);
+    }
+    if(pressure_fd == -1) pressure_fd = pressureOpen("/proc/pressure/memory");
+}
+
+int ttyPressure() {
+    int fired = pressure_fired;
+    pressure_fired = 0;
+    return fired;
+}
+
+/*** output acknowledgements ***/
+/* TIOCOUTQ only sees the queue of a real tty. Behind a pseudo-terminal (a terminal emulator, sshd) the written
+bytes leave the queue at once, and pile up further on, in the ssh connection or the terminal itself. So when the
+low-bandwidth mode follows the link, every frame is followed by a Device Status Report request, <esc>[5n, which
+the terminal answers with <esc>[0n once it has processed everything before it. The answers are taken out of the
+input, and each one tells that the frame before it got there (see ttyBacklog()). A terminal that doesn't answer
+the first OUTPUT_PROBE_TRIES requests isn't asked again.
+
+While the link keeps up, a request goes out at most every OUTPUT_PROBE_NS, which is enough to notice that it
+stopped keeping up: then the answers fall behind, and every frame gets one until the terminal has caught up again
+(E.lowbw, E.backlog). That keeps the requests, and what they cost (below), to the frames where they matter.
+
+On a slow link an answer often comes in two reads. So while answers are due, input that ends with the start of
+one (<esc>, <esc>[ or <esc>[0) stays at the end of pushback, out of the editor's reach (ttyKeys()), until the rest
+arrives; or until OUTPUT_PARTIAL_NS have gone by, and then it was keys after all, like a lone Esc: an Esc pressed
+while an answer is due takes up to that long to be seen. */
+#define OUTPUT_PROBES 64
+#define OUTPUT_PROBE_TRIES 8
+#define OUTPUT_PARTIAL_NS 250000000LL // how long the start of an answer waits for the rest
+#define OUTPUT_PROBE_NS 1000000000LL // how often a link that keeps up is asked
+long long output_written = 0; // bytes queued for the terminal so far, without the frames that were replaced
+long long output_acked = 0; // output_written when the last answered request was sent
+long long output_probe[OUTPUT_PROBES]; // output_written when each unanswered request was sent, oldest first
+int output_probes = 0;
+int output_sent = 0, output_answered = 0;
+long long output_probe_at = 0; // perfNow() time of the last request
+int output_partial = 0; // bytes at the end of pushback that may be the start of an answer
+long long output_partial_at = 0; // when they arrived
+
+int ttyKeys() {
+    // the bytes of pushback that can be handed to the editor
+    return pushback_len - output_partial;
+}
+
+void outputProbe(struct outputFrame *frame) {
+    if(E.lowbw_mode != LOWBW_AUTO || output_probes == OUTPUT_PROBES) return;
+    if(!output_answered && output_sent >= OUTPUT_PROBE_TRIES) return;
+    long long now = perfNow();
+    if(!E.lowbw && E.backlog == 0 && now - output_probe_at < OUTPUT_PROBE_NS) return; // it keeps up, see above
+    output_probe_at = now;
+    memcpy(&frame->b[frame->len], "\x1b[5n", 4);
+    frame->len += 4;
+    frame->probed = 1;
+    output_probe[output_probes++] = output_written + frame->len;
+    output_sent++;
+}
+
+void outputAcks() {
+    // take the answers out of pushback
+    int len = 0;
+    for(int i = 0; i < pushback_len; i++) {
+        if(output_probes > 0 && i + 4 <= pushback_len && !memcmp(&pushback[i], "\x1b[0n", 4)) {
+            output_acked = output_probe[0];
+            memmove(output_probe, &output_probe[1], --output_probes * sizeof(output_probe[0]));
+            output_answered++;
+            i += 3;
+            continue;
         }
-    }
-    abAppend(ab, "\x1b[m", 3);
-    // Space for status message
-    abAppend(ab, "\r\n", 2);
-}
-
-void editorDrawMessageBar(struct abuf *ab) {
-    abAppend(ab, "\x1b[K", 3); // clear the message bar with the <esc>[K escape sequence
-    int msglen = strlen(E.statusmsg);
-    if(msglen > E.screencols) msglen = E.screencols;
-    // refresh only if the message is less than 5 seconds old
-    if(msglen && time(NULL) - E.statusmsg_time < 5) {
-        abAppend(ab, E.statusmsg, msglen);
-    }
-}
-
-
-void editorRefreshScreen() {
-    editorScroll();
-    /*The 4 in our write() call means we are writing 4 bytes out to the terminal. 
-    The first byte is \x1b, which is the escape character, or 27 in decimal.
-
-    We are writing an escape sequence to the terminal. Escape sequences always start with an escape character
-    followed by a [ character. Escape sequences instruct the terminal to do various text formatting tasks, 
-    such as coloring text, moving the cursor around, and clearing parts of the screen.
-
-    We are using the J command (Erase In Display) to clear the screen. Escape sequence commands take arguments,
-    which come before the command. In this case the argument is 2, which says to clear the entire screen. 
-    <esc>[1J would clear the screen up to where the cursor is, and <esc>[0J would clear the screen from the 
-    cursor up to the end of the screen.
-    */
-    // write(STDOUT_FILENO, "\x1b[2J", 4); // clear scren
-    // write(STDERR_FILENO, "\x1b[H", 3); // relocate cursor at top, the default args are row and column 1 and 1
-
-    struct abuf ab = ABUF_INIT;
-    abAppend(&ab, "\x1b[?25l", 6); // hide cursor when repainting
-    // abAppend(&ab, "\x1b[2J", 4); // don't clear full screen, instead clear each line as we redraw it
-    abAppend(&ab, "\x1b[H", 3);
-    editorDrawRows(&ab);
-    editorDrawStatusBar(&ab);
-    editorDrawMessageBar(&ab);
-
-    // move the cursor to the position stored in E.cx and E.cy.
-    char buf[32];
-    // We changed the old H command into an H command with arguments, specifying the exact position 
-    // we want the cursor to move to. We add 1 to (E.cy - offset) and (E.cx - offet) to convert from 0-indexed values to the 1-indexed 
-    // values that the terminal uses.
-    snprintf(buf, sizeof(buf), "\x1b[%d;%dH", (E.cy - E.rowoff) + 1, (E.rx - E.coloff) + 1);
-    abAppend(&ab, buf, strlen(buf));
-
-    // write(STDOUT_FILENO, "\x1b[H", 3);
-    // abAppend(&ab, "\x1b[H", 4); // relocate cursor again
-    abAppend(&ab, "\x1b[?25h", 6); // show cursor again
-
-    // write the full buffer
-    write(STDOUT_FILENO, ab.b, ab.len);
-    abFree(&ab);
-}
-
-void editorSetStatusMessage(const char *fmt, ...) {
-    /* The ... argument makes it a variadic function (it can take any number of arguments)
-    C’s way of dealing with these arguments is by having you call va_start() and va_end() on a value of type va_list. 
-    The last argument before the ... (in this case, fmt) must be passed to va_start(), 
-    so that the address of the next arguments is known. 
-
-    Then, between the va_start() and va_end() calls, you would call va_arg() and pass it the type of the next argument 
-    (which you usually get from the given format string) and it would return the value of that argument. 
-    In this case, we pass fmt and ap to vsnprintf() and it takes care of reading the format string and calling va_arg() 
-    to get each argument.
-    */
-    va_list ap;
-    va_start(ap, fmt);
-    // vsnprintf() helps us make our own printf()-style function. We store the resulting string in E.statusmsg
-    vsnprintf(E.statusmsg, sizeof(E.statusmsg), fmt, ap);
-    va_end(ap);
-    E.statusmsg_time = time(NULL); //  set E.statusmsg_time to the current time, which can be gotten by passing NULL to time()
-}
-
-/*** input ***/
-char *editorPrompt(char *prompt, void (*callback)(char *, int)) {
-    size_t bufsize = 128;
-    char *buf = malloc(bufsize); // The user’s input is stored in buf
-
-    size_t buflen = 0;
-    buf[0] = '\0';
-
-    while(1) {
-        editorSetStatusMessage(prompt, buf);
-        editorRefreshScreen();
-
-        int c = editorReadKey();
-        if(c == DEL_KEY || c == CTRL_KEY('h') || c == BACKSPACE) {
-            if(buflen != 0) buf[--buflen] = '\0';
-        }
-        // user can cancel the operation pressing the scape key
-        else if(c == '\x1b') { // in Bash on Windows, you must press 3 times
-            editorSetStatusMessage("");
-            if(callback) callback(buf, c);
-            free(buf);
-            return NULL;
+        pushback[len++] = pushback[i];
+    }
+    pushback_len = len;
+
+    // hold back the start of an answer, for a while
+    int partial = 0;
+    for(int n = 3; n > 0 && !partial && output_probes > 0; n--) {
+        if(n <= pushback_len && !memcmp(&pushback[pushback_len - n], "\x1b[0n", n)) partial = n;
+    }
+    long long now = perfNow();
+    if(partial && partial != output_partial) output_partial_at = now;
+    if(partial && now - output_partial_at > OUTPUT_PARTIAL_NS) partial = 0; // nothing came after it
+    output_partial = partial;
+}
+
+void outputSettle() {
+    /* On exit: send what is queued, and wait a little for the answers still on their way, or they would end up
+    typed into the shell. */
+    outputDrain();
+    long long deadline = perfNow() + 250000000LL;
+    while(output_probes > 0 && output_answered > 0 && perfNow() < deadline) {
+        struct pollfd pfd = { STDIN_FILENO, POLLIN, 0 };
+        if(poll(&pfd, 1, 10) <= 0) continue;
+        char in[sizeof(pushback)];
+        ssize_t nread = read(STDIN_FILENO, in, sizeof(in) - pushback_len);
+        if(nread > 0) latencyPushback(in, nread, perfNow());
+        outputAcks();
+        if(pushback_len == sizeof(pushback)) pushback_len = 0; // only keys left, and nobody to read them
+    }
+}
+
+/*** tty I/O ***/
+ssize_t ttyRead(void *buf, size_t count) {
+    if(ttyKeys() == 0) {
+        /* wait like read() would (VTIME), but come back early when the window is resized, or when stdout can
+        take more of the queued output */
+        struct pollfd fds[4] = { { STDIN_FILENO, POLLIN, 0 }, { winch_pipe[0], POLLIN, 0 }, { output_fd, 0, 0 },
+            { pressure_fd, POLLPRI, 0 } };
+        if(outputQueued() > 0) fds[2].events = POLLOUT;
+        int ready = poll(fds, 4, 100); // a negative fd (no winch_pipe, no PSI) is skipped
+        if(ready == -1 && errno == EINTR) return 0;
+        if(ready > 0 && (fds[2].revents & POLLOUT)) outputFlush();
+        if(ready > 0 && (fds[3].revents & POLLPRI)) pressure_fired = 1;
+        if(ready > 0 && (fds[3].revents & POLLERR)) { // the cgroup is gone
+            close(pressure_fd);
+            pressure_fd = -1;
         }
-        else if(c == '\r') { // enter key
-            // When the user presses Enter, and their input is not empty, the status message is cleared and their input is returned
-            if(buflen != 0) {
-                editorSetStatusMessage("");
-                if(callback) callback(buf, c);
-                return buf;
-            }
+        if(ready > 0 && (fds[0].revents & POLLIN)) {
+            // read all there is, so the answers to outputProbe() come in whole
+            char in[sizeof(pushback)];
+            ssize_t nread = read(STDIN_FILENO, in, sizeof(in));
+            if(nread == -1) return -1;
+            latencyPushback(in, nread, perfNow());
         }
-        // when they input a printable character, we append it to buf. If buflen has reached the maximum capacity 
-        // we allocated (stored in bufsize), then we double bufsize and allocate that amount of memory before 
-        // appending to buf.
-        else if(!iscntrl(c) && c < 128) { // make sure the input key isn’t one of the special keys in the editorKey enum, which have high integer value
-            if(buflen == bufsize - 1) {
-                bufsize *= 2;
-                buf = realloc(buf, bufsize);
-            }
-            buf[buflen++] = c;
-            buf[buflen] = '\0';
+        outputAcks();
+    }
+    if(ttyKeys() == 0) return 0;
+
+    ssize_t nread = count < (size_t) ttyKeys() ? (ssize_t) count : ttyKeys();
+    memcpy(buf, pushback, nread);
+    memmove(pushback, &pushback[nread], pushback_len - nread);
+    pushback_len -= nread;
+    if(latency_report && !latency_input) latency_input = pushback_at; // when it was typed, not when it's read
+    // keep a copy of every input byte, so the session can be replayed later (see bench/replay.c)
+    if(nread > 0 && record_fd != -1) write(record_fd, buf, nread);
+    return nread;
+}
+
+int ttyPending() {
+    // poll() with a timeout of 0 only looks, it doesn't wait; a resize counts, so idle work makes way for it
+    outputFlush(); // called often while the editor is busy, a good time to send more of the queue
+    struct pollfd fds[2] = { { STDIN_FILENO, POLLIN, 0 }, { winch_pipe[0], POLLIN, 0 } };
+    if(poll(fds, winch_pipe[0] != -1 ? 2 : 1, 0) <= 0) return ttyKeys() > 0;
+    if(fds[0].revents & POLLIN) { // it may only be answers to outputProbe(), which aren't keys
+        char in[sizeof(pushback)];
+        ssize_t nread = pushback_len < (int) sizeof(pushback) ? read(STDIN_FILENO, in, sizeof(in) - pushback_len) : 0;
+        if(nread > 0) latencyPushback(in, nread, perfNow());
+        outputAcks();
+    }
+    return ttyKeys() > 0 || (fds[1].revents & POLLIN);
+}
+
+void ttyInterruptRead(int timeout) {
+    // move what has been typed to pushback, waiting up to timeout ms for it
+    struct pollfd pfd = { STDIN_FILENO, POLLIN, 0 };
+    int room = sizeof(pushback) - pushback_len;
+    if(room > 0 && poll(&pfd, 1, timeout) > 0) {
+        char in[sizeof(pushback)];
+        ssize_t nread = read(STDIN_FILENO, in, room);
+        if(nread > 0) latencyPushback(in, nread, perfNow());
+    }
+    outputAcks();
+}
+
+int ttyInterrupt() {
+    /* Called from the long loops of the core (see editorInterrupted()) to know if the user wants them to stop.
+    Whatever has been typed is moved to pushback, so no key is lost. An Esc stays there, so it then also cancels
+    the prompt that started the loop, like a search. Ctrl-C means the same here but isn't a key of the editor,
+    so it becomes an Esc. An Esc followed by [ or O is the start of an arrow key, and doesn't count. An Esc that
+    came last may be one whose [ or O is still on its way (over ssh, the bytes of a key can come in two reads):
+    it only counts if nothing follows it for as long as editorDecodeKey() waits for the rest of a sequence. */
+    ttyInterruptRead(0);
+    for(int waited = 0; ; waited = 1) {
+        int trailing = 0;
+        for(int i = 0; i < ttyKeys(); i++) {
+            if(pushback[i] == CTRL_KEY('c')) pushback[i] = '\x1b';
+            if(pushback[i] != '\x1b') continue;
+            if(i + 1 == ttyKeys()) trailing = 1;
+            else if(pushback[i + 1] != '[' && pushback[i + 1] != 'O') return 1;
         }
-
-        if (callback) callback(buf, c);
-    }
+        if(!trailing) return 0;
+        if(waited) return 1; // nothing came after it, it was a lone Esc
+        ttyInterruptRead(100); // the VTIME of ttyRead()
+    }
+}
+
+ssize_t ttyWrite(const void *buf, size_t count) {
+    // queue the frame, in place of the one that is still waiting (see the output queue section)
+    struct outputFrame *frame = out_now.sent < out_now.len ? &out_next : &out_now;
+    if(frame == &out_next && out_next.len > 0) { // it will never be shown, nor answered, nor measured
+        output_written -= out_next.len;
+        if(out_next.probed) output_probes--;
+        editorFrameDropped(); // nor what it drew of the windows
+    }
+    char *b = yateRealloc(frame->b, count + 4); // room for outputProbe()
+    if(!b) return -1;
+    frame->b = b;
+    memcpy(frame->b, buf, count);
+    frame->len = count;
+    frame->sent = 0;
+    frame->probed = 0;
+    frame->input = count > 0 ? latency_input : 0; // measured once it's all written, see latencyFrameWritten()
+    latency_input = 0;
+    outputProbe(frame);
+    output_written += frame->len;
+    outputFlush();
+    return count;
+}
+
+int ttyBacklog() {
+    /* Bytes still in the output queue of the tty, that the terminal (or sshd) hasn't read yet, plus those not
+    written yet (see the output queue), and those of the frames before the last one that the terminal hasn't
+    answered for (see outputProbe()). */
+    int queued;
+    if(ioctl(STDOUT_FILENO, TIOCOUTQ, &queued) == -1) queued = 0;
+    queued += outputQueued();
+    if(output_answered > 0 && output_probes >= 2) queued += output_probe[output_probes - 2] - output_acked;
+    return queued;
+}
+
+/*** terminal capabilities ***/
+/* Terminals don't say what they support unless asked, and don't answer what they don't understand. So every
+question is followed by a Primary Device Attributes request (DA1, <esc>[c), which all of them answer: once that
+answer is in, any other answer has arrived too, or never will. Keys typed in the meantime go to pushback. */
+int terminalQuery(const char *query, char *answer, int size) {
+    /* Send query, and store what comes back up to the end of the DA1 answer in answer, as a string.
+    Returns its length, or -1 if the terminal didn't answer within a second. */
+    char request[64];
+    int len = snprintf(request, sizeof(request), "%s\x1b[c", query);
+    if(write(STDOUT_FILENO, request, len) != len) return -1;
+
+    char in[256];
+    int n = 0;
+    long long deadline = perfNow() + 1000000000LL;
+    while(n < (int) sizeof(in) - 1 && perfNow() < deadline) {
+        if(read(STDIN_FILENO, &in[n], 1) != 1) continue;
+        n++;
+        if(in[n - 1] != 'c') continue;
+
+        // is it the end of <esc>[?<digits and ;>c ?
+        int start = n - 2;
+        while(start >= 0 && (isdigit((unsigned char) in[start]) || in[start] == ';')) start--;
+        if(start < 2 || in[start] != '?' || in[start - 1] != '[' || in[start - 2] != '\x1b') continue;
+
+        // what came before the first answer was typed by the user
+        int first = 0;
+        while(first < n && in[first] != '\x1b') first++;
+        latencyPushback(in, first, perfNow());
+        len = n - first < size - 1 ? n - first : size - 1;
+        memcpy(answer, &in[first], len);
+        answer[len] = '\0';
+        return len;
+    }
+    latencyPushback(in, n, perfNow());
+    return -1;
+}
+
+void terminalCapabilities() {
+    /* Ask what the terminal can do, with a single round trip:
+    - synchronized output (mode 2026), with DECRQM. The answer is <esc>[?2026;<n>$y, where n is 1 (set)
+      or 2 (reset) when the mode is known;
+    - REP and ECH (see editorAppendRun()), from the DA1 answer itself, <esc>[?<class>;...c. ECH came
+      with the VT220 (class 62), and every terminal that claims the VT420 (64) or newer also knows REP. */
+    char answer[256];
+    if(terminalQuery("\x1b[?2026$p", answer, sizeof(answer)) == -1) return;
+    char *mode = strstr(answer, "\x1b[?2026;");
+    E.sync_output = mode && (mode[8] == '1' || mode[8] == '2') && mode[9] == '$';
+
+    char *da1 = answer, *next;
+    while((next = strstr(da1 + 1, "\x1b[?"))) da1 = next; // the DA1 answer is the last one
+    int class = atoi(da1 + 3);
+    E.term_ech = class >= 62;
+    E.term_rep = class >= 64;
+}
+
+/*** memory report ***/
+void writeMemoryReport() {
+    // appends, so a whole fleet of sessions can share one file
+    FILE *fp = fopen(memreport, "a");
+    if(!fp) return;
+    editorMemoryReport(fp);
+    fclose(fp);
 }
 
+/*** init ***/
+int main(int argc, char const *argv[]) {
+    /* YATE_RECORD=file records every key of the session, in the format bench/replay -k reads */
+    const char *record = getenv("YATE_RECORD");
+    if(record) record_fd = open(record, O_WRONLY | O_CREAT | O_TRUNC, 0644);
 
-void editorMoveCursor(int key) {
-    erow *row = (E.cy >= E.numrows) ? NULL : &E.row[E.cy];
-
-    switch (key) {
-        case ARROW_LEFT:
-            if(E.cx != 0) {
-                E.cx--;
-            }
-            else if(E.cy > 0) {
-                E.cy--;
-                E.cx = E.row[E.cy].size;
-            }
-            break;
-        case ARROW_RIGHT:
-            if(row && E.cx < row->size) {
-                E.cx++;
-            }
-            else if(row && E.cx == row->size) {
-                E.cy++;
-                E.cx = 0;
-            }
-            break;
-        case ARROW_UP:
-            if(E.cy != 0) {
-                E.cy--;
-            }
-            break;
-        case ARROW_DOWN:
-            if(E.cy < E.numrows) {
-                E.cy++;
-            }
-            break;
-    }
-
-    row = (E.cy >= E.numrows) ? NULL : &E.row[E.cy];
-    int rowlen = row ? row->size : 0;
-    if(E.cx > rowlen) {
-        E.cx = rowlen;
-    }
-}
+    /* YATE_MEMREPORT=file appends the memory report of the session (see Ctrl-G) to file when quitting */
+    memreport = getenv("YATE_MEMREPORT");
+    if(memreport) atexit(writeMemoryReport);
 
+    /* YATE_ALLOC_REPORT=file appends the top allocating call sites to file when quitting (make ALLOC_STATS=1) */
+    allocreport = getenv("YATE_ALLOC_REPORT");
+    if(allocreport) atexit(writeAllocReport);
 
-void editorProcessKeypress() {
-    static int quit_times = KILO_QUIT_TIMES;
-
-    /* waits for a keypress, and then handles it. */
-    int c = editorReadKey();
-
-    switch (c) {
-        case '\r': // enter key
-            editorInsertNewLine();
-            break;
-        case CTRL_KEY('q'):
-            // quit confirmation
-            if(E.dirty && quit_times > 0) {
-                editorSetStatusMessage("WARNING!!! File has unsaved changes. "
-                    "Press Ctrl-Q %d more times to quit.", quit_times
-                );
-                quit_times--;
-                return;
-            }
-            // reset screen
-            write(STDOUT_FILENO, "\x1b[2J", 4); // clear scren
-            write(STDERR_FILENO, "\x1b[H", 3); // relocate cursor position
-            exit(0);
-            break;
-        case CTRL_KEY('s'):
-            editorSave();
-            break;
-        case HOME_KEY:
-            E.cx = 0;
-            break;
-        case END_KEY:
-            if(E.cy < E.numrows) {
-                E.cx = E.row[E.cy].size;
-            }
-            E.cx = E.screencols - 1;
-            break;
-        case CTRL_KEY('f'):
-            editorFind();
-            break;
-        case BACKSPACE:
-        case CTRL_KEY('h'): // it sends the control code 8, which is originally what the Backspace character would send back in the day.
-        case DEL_KEY:
-            if (c == DEL_KEY) editorMoveCursor(ARROW_RIGHT);
-            editorDelChar();
-            break;
-        // If you’re on a laptop with an Fn key, you may be able to press Fn+↑ and Fn+↓ to simulate pressing 
-        // the Page Up and Page Down keys.
-        case PAGE_UP:
-        case PAGE_DOWN:
-            {      
-                if(c == PAGE_UP) {
-                    E.cy = E.rowoff;
-                }
-                else if(c == PAGE_DOWN) {
-                    E.cy = E.rowoff + E.screenrows - 1;
-                    if(E.cy > E.numrows) E.cy = E.numrows;
-                }
-
-                int times = E.screenrows;
-                while(times--) {
-                    editorMoveCursor(c == PAGE_UP ? ARROW_UP : ARROW_DOWN);
-                }
-            }
-            break;
-        case ARROW_UP:
-        case ARROW_DOWN:
-        case ARROW_LEFT:
-        case ARROW_RIGHT:
-            editorMoveCursor(c);
-            break;
-        case CTRL_KEY('l'): // Ctrl-L is traditionally used to refresh the screen in terminal programs
-        case '\x1b': // gnore the Escape key because there are many key escape sequences that we aren’t handling (such as the F1–F12 keys),
-            break;
-        default:
-            editorInsertChar(c);
-            break;
+    // see the latency section above
+    latency_report = getenv("YATE_LATENCY");
+    if(latency_report) {
+        const char *probe = getenv("YATE_LATENCY_PROBE");
+        latency_probe = probe && strcmp(probe, "0") != 0;
+        atexit(writeLatencyReport);
     }
 
-    quit_times = KILO_QUIT_TIMES;
-}
-
-
-/*** init ***/
-void initEditor() {
-    E.cx = 0;
-    E.cy = 0;
-    E.rx = 0;
-    E.numrows = 0;
-    E.rowoff = 0; // We initialize it to 0, which means we’ll be scrolled to the top of the file by default.
-    E.coloff = 0; // same idea as the rowoff's initialization
-    E.row = NULL;
-    E.dirty = 0;
-    E.filename = NULL;
-    E.statusmsg[0] = '\0'; // empty character
-    E.statusmsg_time = 0;
-    E.syntax = NULL; // When E.syntax is NULL, that means there is no filetype for the current file, and no syntax highlighting should be done.
-
-    if(getWindowSize(&E.screenrows, &E.screencols) == -1) die("getWindowSize");
-
-    // don't draw nothing in the last two lines, reserve the last rows for the status bar and status message
-    E.screenrows -= 2;
-}
-
+    /* YATE_TRACE=file.json records a Chrome trace-event timeline of the session, see trace.h */
+    const char *trace = getenv("YATE_TRACE");
+    if(trace && traceStart(trace) == 0) atexit(traceStop);
 
-int main(int argc, char const *argv[]) {
     enableRawMode();
-    initEditor();
+    atexit(outputSettle); // before disableRawMode(), atexit() runs them backwards
+
+    int rows, cols;
+    if(getWindowSize(&rows, &cols) == -1) die("getWindowSize");
+    struct editorIO io = { ttyRead, ttyWrite, ttyPending, ttyInterrupt, ttyResized, ttyBacklog, ttyPressure };
+    initEditor(io, rows, cols);
+    watchResize();
+    watchMemoryPressure();
+    terminalCapabilities();
+
+    /* YATE_LOWBW=on or off forces the low-bandwidth rendering (see editor.c) instead of following the link */
+    const char *lowbw = getenv("YATE_LOWBW");
+    if(lowbw && !strcmp(lowbw, "on")) E.lowbw_mode = LOWBW_ON;
+    if(lowbw && !strcmp(lowbw, "off")) E.lowbw_mode = LOWBW_OFF;
+
+    // the terminal has answered, from now on writes don't wait (see the output queue section)
+    outputOpen();
+    poolStart(0); // one worker per core, for saving in the background and drawing big frames
+
+    /* YATE_COMPOSE_CELLS=n draws the rows in parallel from n cells on (see editorComposeRows()), 0 never */
+    const char *compose = getenv("YATE_COMPOSE_CELLS");
+    if(compose) E.compose_cells = atoi(compose);
+
+    /* YATE_BUFFER_BUDGET=n[K|M|G] is what the buffers may take before they give back their render and highlight,
+    the hidden buffers first, then the rows the farthest from the windows; 0 no limit */
+    const char *budget = getenv("YATE_BUFFER_BUDGET");
+    if(budget) {
+        char *unit;
+        E.buffer_budget = strtoull(budget, &unit, 10);
+        if(*unit == 'K' || *unit == 'k') E.buffer_budget <<= 10;
+        if(*unit == 'M' || *unit == 'm') E.buffer_budget <<= 20;
+        if(*unit == 'G' || *unit == 'g') E.buffer_budget <<= 30;
+    }
 
     if(argc >= 2) {
-        editorOpen(argv[1]);
+        // draw the first screen as soon as possible, and highlight the rest of the file when there is time
+        E.buf->hl_lazy = 1;
+        // a file that doesn't exist yet is an empty buffer with its name, like the others, and saving creates it
+        if(editorOpen(E.buf, (char *) argv[1]) == -1 && errno != EINTR && errno != ENOENT) die("fopen");
+        editorHighlightInBackground();
+        for(int i = 2; i < argc; i++) editorAddFile(argv[i]); // opened when they are first shown, see Ctrl-N
     }
 
-    editorSetStatusMessage("HELP: Ctrl-S = save | Ctrl-Q = quit | Ctrl-F = find");
-
-    char c;
+    editorSetStatusMessage("HELP: Ctrl-S = save | Ctrl-Q = quit | Ctrl-F = find | Ctrl-B = block%s",
+        E.nfiles > 1 ? " | Ctrl-N = next file" : "");
+    editorReportInterrupt(); // if the file was too big to wait for
 
     while(1) {
-        editorRefreshScreen();
+        editorFrame();
         editorProcessKeypress();
     }
     return 0;